@@ -44,6 +44,9 @@
 #include <sys/resource.h>
 #include <sys/stat.h>
 #include <fstream>
+#include <thread>
+#include <atomic>
+#include <functional>
 #include "bitvector.h"
 #include "packed_view.h"
 #include <assert.h>
@@ -76,7 +79,7 @@ typedef bitvector_t<W_leafs> bitv;
 
 enum input_mode {file_path,text};//input is a file path or a text string?
 
-enum hash_type {DNA_SEARCH,BS_SEARCH,QUALITY_DNA_SEARCH,QUALITY_BS_SEARCH,DEFAULT};
+enum hash_type {DNA_SEARCH,BS_SEARCH,QUALITY_DNA_SEARCH,QUALITY_BS_SEARCH,DEFAULT,SPACED_DNA_SEARCH};
 
 #include "../extern/getRSS.h"
 
@@ -263,6 +266,46 @@ inline void save_packed_view_to_file(packed_view_t pv, size_t size,FILE * fp){
 
 }
 
+/*
+ * split [0,n) in chunks of grain elements and process them with nr_of_threads threads: f(begin,end) is called once for each chunk.
+ * To write a packed_view in parallel, grain must be a multiple of 64: chunks then start at word boundaries.
+ */
+inline void parallel_for(ulint n, ulint grain, uint nr_of_threads, std::function<void(ulint, ulint)> f){
+
+	assert(grain>0);
+
+	ulint nr_of_chunks = (n+grain-1)/grain;
+
+	if(nr_of_threads<=1 or nr_of_chunks<=1){
+
+		for(ulint b=0;b<n;b+=grain)
+			f(b,std::min(b+grain,n));
+
+		return;
+
+	}
+
+	std::atomic<ulint> next_chunk(0);
+
+	auto worker = [&](){
+
+		ulint k;
+
+		while((k = next_chunk++) < nr_of_chunks)
+			f(k*grain,std::min((k+1)*grain,n));
+
+	};
+
+	vector<std::thread> threads;
+
+	for(uint t=0;t<std::min((ulint)nr_of_threads,nr_of_chunks);t++)
+		threads.push_back(std::thread(worker));
+
+	for(auto &t : threads)
+		t.join();
+
+}
+
 inline packed_view_t load_packed_view_from_file(size_t width, size_t size, FILE * fp){
 
 	 packed_view_t pv = packed_view_t(width,size);
@@ -25,24 +25,66 @@
 #define DBHASH_H_
 
 #include "../common/common.h"
+#include <chrono>
 #include "HashFunction.h"
 #include "IndexedBWT.h"
 #include "../algorithms/cw_bwt.h"
 
 namespace bwtil {
 
-class DBhash {
+/*
+ * hash_policy is the policy of the de Bruijn hash function (see HashPolicies.h). DBhash uses the runtime policy,
+ * which covers all the hash types selectable at runtime.
+ */
+template<class hash_policy>
+class DBhash_t {
 
 public:
 
-	DBhash(){};
-
-	DBhash(string &text, HashFunction h, ulint offrate = 16, bool verbose = false){
+	/*
+	 * statistics of an approximate search. Entry e of the vectors refers to the fingerprints at e errors
+	 * from the fingerprint of the pattern (elements of Z(e)).
+	 */
+	struct search_stats{
+
+		vector<ulint> probes;//number of fingerprints searched
+		vector<ulint> candidates;//number of candidate occurrences located
+		vector<double> locate_ns;//time spent searching and locating the fingerprints (nanoseconds)
+
+		ulint occurrences=0;//number of candidates at Hamming distance <= max_errors from the pattern
+		double verify_ns=0;//time spent verifying the candidates (nanoseconds)
+
+	};
+
+	/*
+	 * storage of the text used to verify the candidates:
+	 * - plain_text: log2(sigma) bits per character.
+	 * - packed_text: the most frequent characters are packed in fewer bits and the runs of the others are stored in a
+	 *   list of exceptions (e.g. 2 bits per character and the runs of N on DNA). The number of bits per character minimizes
+	 *   the total space.
+	 */
+	enum text_format {plain_text, packed_text};
+
+	DBhash_t(){};
+
+	/*
+	 * nr_of_threads threads are used in the construction phases that can be parallelized: fingerprinting
+	 * of the text, packing of the text and auxiliary hash. The BWT and its sampling are computed sequentially.
+	 * If overload_threshold>0, the fingerprints with more than overload_threshold occurrences are overloaded: their text
+	 * positions are stored explicitly (see initOverloadIndex), so that queries falling in them do not pay one locate per candidate.
+	 * format selects the storage of the text (see text_format).
+	 */
+	DBhash_t(	string &text, HashFunction_t<hash_policy> h, ulint offrate = 16, bool verbose = false, uint nr_of_threads = 1,
+				ulint overload_threshold = 0, text_format format = plain_text){
 
 		if(verbose)	cout << "\nBuilding dB-hash data structure" <<endl;
 
+		build_report.clear();
+		auto t = phaseStart();
+
 		this->n = text.length();
 		this->h = h;
+		policy = h.hashPolicy();
 		this->offrate = offrate;
 
 		m = h.m;
@@ -52,11 +94,11 @@ public:
 
 		if(verbose) cout << " Text fingerprint length = " << text_fingerprint_length<<endl;
 
-		w_aux = ceil( ( log2(n) - log2(log2(n)) )/log2(h.base) );//log_b n - log_b log_2 n
+		w_aux = ceil( ( log2(n) - log2(log2(n)) )/log2(policy.base()) );//log_b n - log_b log_2 n
 
 		if(w_aux>w) w_aux=w;
 
-		auxiliary_hash_size = 1 << (w_aux * h.log_base);
+		auxiliary_hash_size = 1 << (w_aux * policy.logBase());
 
 		if(verbose)	cout << " w = " << w <<endl;
 		if(verbose)	cout << " w_aux = " << w_aux <<endl;
@@ -66,15 +108,19 @@ public:
 		{
 
 			if(verbose)	cout << " Computing hash value h(T) of the text ..." << flush;
-			string fingerprint = h.hashValueRemapped(text);//hash value where 1 is added to each digit
+			string fingerprint = h.hashValueRemapped(text,nr_of_threads);//hash value where 1 is added to each digit
 			if(verbose)	cout << " Done.\n";
 
+			t = phaseEnd("fingerprint h(T)",t);
+
 			if(verbose)	cout << " Computing BWT(h(T))  ..." <<flush;
 
 			cwbwt = new cw_bwt(fingerprint,cw_bwt::text,verbose);
 
 			if(verbose)	cout << " Done.\n";
 
+			t = phaseEnd("BWT(h(T))",t);
+
 		}//fingerprint is deleted
 
 		{
@@ -87,14 +133,30 @@ public:
 
 		}//bwt is deleted
 
-		if(verbose)	cout << " Storing text T in plain format ...";
-		initText(text);
-		if(verbose)	cout << " Done.\n";
+		t = phaseEnd("indexed BWT",t);
+
+		if(verbose)	cout << (format==plain_text ? " Storing text T in plain format ..." : " Storing text T in packed format with exceptions ...");
+		initText(text,nr_of_threads,format);
+		if(verbose)	cout << " Done. " << (double)textSize()/n << " bits per character (" << numberOfExceptionRuns() << " exception runs).\n";
+
+		t = phaseEnd("text packing",t);
 
 		if(verbose)	cout << "\n  Building auxiliary hash ... " << endl;
-		initAuxHash();
+		initAuxHash(nr_of_threads,verbose);
 		if(verbose)	cout << "  Done. " << endl;
 
+		t = phaseEnd("auxiliary hash",t);
+
+		if(overload_threshold>0){
+
+			if(verbose)	cout << " Indexing fingerprints with more than " << overload_threshold << " occurrences ...";
+			initOverloadIndex(overload_threshold,nr_of_threads);
+			if(verbose)	cout << " Done. " << overloaded.size() << " overloaded fingerprints, " << overloadedPositions() << " positions stored.\n";
+
+			t = phaseEnd("overloaded fingerprints",t);
+
+		}
+
 		if(verbose)	cout << "\nDone. Size of the structure = " << (double)size()/(n*8) << "n Bytes" <<endl;
 
 	}
@@ -102,105 +164,108 @@ public:
 	//doesn't use auxiliary hash.
 	vector<ulint> getOccurrences_slow(ulint fingerprint){
 
-		return indexedBWT.convertToTextCoordinates( indexedBWT.BS(fingerprint,w) );
+		return indexedBWT.convertToTextCoordinates( indexedBWT.BS(fingerprint,w,pair<ulint, ulint>(0,0),policy.logBase()) );
 
 	}
 
 	//returns occurrences in the text of substrings having 'fingerprint' as hash value. uses the auxiliary hash.
 	vector<ulint> getOccurrences(ulint fingerprint){
 
-		ulint mask = auxiliary_hash_size-1;
+		return locate( fingerprint, getInterval(fingerprint) );
 
-		ulint suffix = fingerprint & mask;//suffix of length w_aux. Searched in the auxiliary hash
-		ulint prefix = fingerprint >> (w_aux*h.log_base);//prefix of the fingerprint of length log m/log base to be searched with backward search
+	}
 
-		pair<ulint, ulint> interval;
+	//returns number of occurrences of the fingerprint. uses the auxiliary hash.
+	ulint numberOfOccurrences(ulint fingerprint){
 
-		interval.first = auxiliary_hash[suffix];
+		pair<ulint, ulint> interval = getInterval(fingerprint);
 
-		if (suffix + 1 == auxiliary_hash_size)
-			interval.second = text_fingerprint_length + 1;
-		else
-			interval.second = auxiliary_hash[suffix+1];
+		return interval.second>interval.first ? interval.second - interval.first : 0;
+
+	}
+
+	//returns first cl occurrences in the text of substrings having 'fingerprint' as hash value. uses the auxiliary hash.
+	vector<ulint> getOccurrencesUpTo(ulint fingerprint,uint cl){
 
-		return indexedBWT.convertToTextCoordinates( indexedBWT.BS(prefix,w-w_aux,interval) );
+		return locate( fingerprint, getInterval(fingerprint), cl );
 
 	}
 
-	//returns number of occurrences of the fingerprint. uses the auxiliary hash.
-	ulint numberOfOccurrences(ulint fingerprint){
+	//result[i] = number of hash lists with i entries.
+	//max number of entries detected=10000
+	//result[10000] = number of hash lists with >= than 10000 entries.
+	//can be used for statistics. Only the fingerprints occurring in the text are visited (depth-first visit of the fingerprint
+	//trie, see fingerprintDFS): the other entries are counted in result[0].
+	vector<ulint> hashLoad(){
 
-		ulint mask = auxiliary_hash_size-1;
+		ulint max_length = 10000;//max length detected
 
-		ulint suffix = fingerprint & mask;//suffix of length w_aux. Searched in the auxiliary hash
-		ulint prefix = fingerprint >> (w_aux*h.log_base);//prefix of the fingerprint of length log m/log base to be searched with backward search
+		vector<ulint> stats(max_length+1,0);
 
-		pair<ulint, ulint> interval;
+		ulint nonempty = 0;
 
-		interval.first = auxiliary_hash[suffix];
+		auto visit = [&](ulint fingerprint, pair<ulint, ulint> interval){
 
-		if (suffix + 1 == auxiliary_hash_size)
-			interval.second = text_fingerprint_length + 1;
-		else
-			interval.second = auxiliary_hash[suffix+1];
+			ulint occ = interval.second-interval.first;
 
-		interval = indexedBWT.BS(prefix,w-w_aux,interval);
+			stats[occ<max_length ? occ : max_length]++;
+			nonempty++;
 
-		return interval.second - interval.first;
+		};
 
-	}
+		fingerprintDFS(pair<ulint, ulint>(0,indexedBWT.length()), 0, 0, 0, visit);
 
-	//returns first cl occurrences in the text of substrings having 'fingerprint' as hash value. uses the auxiliary hash.
-	vector<ulint> getOccurrencesUpTo(ulint fingerprint,uint cl){
+		if(w*policy.logBase()<64)
+			stats[0] = (((ulint)1)<<(w*policy.logBase())) - nonempty;//number of hash entries minus nonempty entries
 
-		ulint mask = auxiliary_hash_size-1;
+		return stats;
 
-		ulint suffix = fingerprint & mask;//suffix of length w_aux. Searched in the auxiliary hash
-		ulint prefix = fingerprint >> (w_aux*h.log_base);//prefix of the fingerprint of length log m/log base to be searched with backward search
+	}
 
-		pair<ulint, ulint> interval;
+	/*
+	 * fingerprints with more than threshold occurrences, with their BWT intervals (sorted by fingerprint).
+	 * Subtrees of the fingerprint trie with at most threshold occurrences are pruned, so at most
+	 * w*text_fingerprint_length/threshold nodes are visited.
+	 */
+	vector<pair<ulint, pair<ulint, ulint> > > overloadedFingerprints(ulint threshold){
 
-		interval.first = auxiliary_hash[suffix];
+		vector<pair<ulint, pair<ulint, ulint> > > result;
 
-		if (suffix + 1 == auxiliary_hash_size)
-			interval.second = text_fingerprint_length + 1;
-		else
-			interval.second = auxiliary_hash[suffix+1];
+		auto visit = [&](ulint fingerprint, pair<ulint, ulint> interval){
+			result.push_back(pair<ulint, pair<ulint, ulint> >(fingerprint,interval));
+		};
 
-		interval = indexedBWT.BS(prefix,w-w_aux,interval);
+		fingerprintDFS(pair<ulint, ulint>(0,indexedBWT.length()), 0, 0, threshold, visit);
 
-		if(cl>0 and interval.second-interval.first>cl)//truncate interval
-			interval.second = interval.first+cl;
+		std::sort(result.begin(),result.end());
 
-		return indexedBWT.convertToTextCoordinates( interval );
+		return result;
 
 	}
 
-	//result[i] = number of hash lists with >= than i entries.
-	//max number of entries detected=10000
-	//result[10000] = number of hash lists with > than 10000 entries.
-	//can be used for statistics.
-	vector<ulint> hashLoad(){
+	//number of fingerprints with a stored position list, and number of positions stored
+	ulint numberOfOverloadedFingerprints(){return overloaded.size();}
+	ulint overloadedPositions(){return overloaded.size()==0 ? 0 : overload_begin.back();}
 
-		ulint hash_size = ((ulint)1)<<(w*log_sigma);//number of hash entries
-		ulint max_length = 10000;//max length detected
+	//time and memory of each construction phase (available only after construction, not after loading from file)
+	void printBuildReport(){
 
-		vector<ulint> stats(max_length+1,0);
+		cout << "phase\ttime (s)\tRSS at end (MB)\tpeak RSS (MB)" << endl;
 
-		for(ulint i=0;i<hash_size;i++){
+		double total = 0;
 
-			ulint occ = numberOfOccurrences(i);
-			if(occ<max_length)
-				stats[occ]++;
-			else
-				stats[max_length]++;
+		for(auto p : build_report){
+
+			cout << p.name << "\t" << p.seconds << "\t" << (double)p.rss/(1<<20) << "\t" << (double)p.peak_rss/(1<<20) << endl;
+			total += p.seconds;
 
 		}
 
-		return stats;
+		cout << "total\t" << total << endl;
 
 	}
 
+	//prints the nonzero entries of hashLoad()
 	void printHashLoad(){
 
 		cout << "Hash Load:" << endl;
@@ -208,7 +273,8 @@ public:
 		vector<ulint> stats = hashLoad();
 
 		for(ulint i=0;i<stats.size();i++)
-			cout << i << "\t" << stats[i] << endl;
+			if(stats[i]>0)
+				cout << i << "\t" << stats[i] << endl;
 
 		cout << endl;
 
@@ -216,12 +282,30 @@ public:
 
 	ulint size(){//returns size of the structure in bits
 
-		return indexedBWT.size() + text_wv.size()*text_wv.width() + auxiliary_hash.size()*auxiliary_hash.width();
+		return 	indexedBWT.size() + textSize() + auxiliary_hash.size()*auxiliary_hash.width() +
+				overloaded.size()*64 + overload_begin.size()*64 +
+				overloadedPositions()*(overload_pos.width() + overload_key.width());
+
+	}
+
+	//size in bits of the text used for verification (packed characters and exceptions)
+	ulint textSize(){
+
+		return text_wv.size()*text_wv.width() + nr_of_exception_runs*(exception_begin.width()+exception_length.width()+exception_char.width());
 
 	}
 
+	ulint numberOfExceptionRuns(){return nr_of_exception_runs;}
+
 	uchar textAt(ulint i){
+
+		ulint r = exceptionRun(i);
+
+		if(r<nr_of_exception_runs and i<exception_begin[r]+exception_length[r])
+			return int_to_char[exception_char[r]];
+
 		return int_to_char[text_wv[i]];
+
 	}
 
 	void saveToFile(string path){
@@ -262,7 +346,7 @@ public:
 		fwrite(&auxiliary_hash_size, sizeof(ulint), 1, fp);
 		fwrite(&text_fingerprint_length, sizeof(ulint), 1, fp);
 		fwrite(&sigma, sizeof(uint), 1, fp);
-		fwrite(&log_sigma, sizeof(uint), 1, fp);
+		fwrite(&text_width, sizeof(uint), 1, fp);//bits per character of the packed text (log_sigma in plain format)
 
 		assert(char_to_int.size()==256);
 		fwrite(char_to_int.data(), sizeof(uint), 256, fp);
@@ -276,6 +360,36 @@ public:
 		save_packed_view_to_file(text_wv,n,fp);
 		save_packed_view_to_file(auxiliary_hash,auxiliary_hash_size,fp);
 
+		//position lists of the overloaded fingerprints (absent in files written before they were introduced)
+
+		ulint nr_of_overloaded = overloaded.size();
+
+		fwrite(&overload_threshold, sizeof(ulint), 1, fp);
+		fwrite(&nr_of_overloaded, sizeof(ulint), 1, fp);
+
+		if(nr_of_overloaded>0){
+
+			fwrite(&key_length, sizeof(uint), 1, fp);
+			fwrite(overloaded.data(), sizeof(ulint), nr_of_overloaded, fp);
+			fwrite(overload_begin.data(), sizeof(ulint), nr_of_overloaded+1, fp);
+
+			save_packed_view_to_file(overload_pos,overloadedPositions(),fp);
+			save_packed_view_to_file(overload_key,overloadedPositions(),fp);
+
+		}
+
+		//exceptions of the packed text
+
+		fwrite(&nr_of_exception_runs, sizeof(ulint), 1, fp);
+
+		if(nr_of_exception_runs>0){
+
+			save_packed_view_to_file(exception_begin,nr_of_exception_runs,fp);
+			save_packed_view_to_file(exception_length,nr_of_exception_runs,fp);
+			save_packed_view_to_file(exception_char,nr_of_exception_runs,fp);
+
+		}
+
 	}
 
 	void loadFromFile(FILE *fp){
@@ -296,9 +410,12 @@ public:
 		assert(numBytes>0);
 		numBytes = fread(&sigma, sizeof(uint), 1, fp);
 		assert(numBytes>0);
-		numBytes = fread(&log_sigma, sizeof(uint), 1, fp);
+		numBytes = fread(&text_width, sizeof(uint), 1, fp);
 		assert(numBytes>0);
 
+		log_sigma = ceil(log2(sigma));
+		if(log_sigma==0) log_sigma=1;
+
 		char_to_int = vector<uint>(256);
 		int_to_char = vector<uchar>(sigma);
 
@@ -307,23 +424,68 @@ public:
 		numBytes = fread(int_to_char.data(), sizeof(uchar), sigma, fp);
 		assert(numBytes>0);
 
-		h = HashFunction();
+		h = HashFunction_t<hash_policy>();
 		h.loadFromFile(fp);
+		policy = h.hashPolicy();
 
 		indexedBWT =  IndexedBWT();
 		indexedBWT.loadFromFile(fp);
 
-		text_wv = load_packed_view_from_file(log_sigma,n,fp);
+		text_wv = load_packed_view_from_file(text_width,n,fp);
 
 		auxiliary_hash = load_packed_view_from_file(ceil(log2(n+1)),auxiliary_hash_size,fp);
 
+		overload_threshold = 0;
+		overloaded.clear();
+		overload_begin.clear();
+
+		ulint nr_of_overloaded = 0;
+
+		if(fread(&overload_threshold, sizeof(ulint), 1, fp)==1){
+
+			numBytes = fread(&nr_of_overloaded, sizeof(ulint), 1, fp);
+			assert(numBytes>0);
+
+		}else
+			overload_threshold = 0;
+
+		if(nr_of_overloaded>0){
+
+			numBytes = fread(&key_length, sizeof(uint), 1, fp);
+			assert(numBytes>0);
+
+			overloaded = vector<ulint>(nr_of_overloaded);
+			overload_begin = vector<ulint>(nr_of_overloaded+1);
+
+			numBytes = fread(overloaded.data(), sizeof(ulint), nr_of_overloaded, fp);
+			assert(numBytes>0);
+			numBytes = fread(overload_begin.data(), sizeof(ulint), nr_of_overloaded+1, fp);
+			assert(numBytes>0);
+
+			overload_pos = load_packed_view_from_file(ceil(log2(n+1)),overloadedPositions(),fp);
+			overload_key = load_packed_view_from_file(key_length*text_width,overloadedPositions(),fp);
+
+		}
+
+		//exceptions of the packed text (absent in files written before they were introduced)
+		if(fread(&nr_of_exception_runs, sizeof(ulint), 1, fp)!=1)
+			nr_of_exception_runs = 0;
+
+		if(nr_of_exception_runs>0){
+
+			exception_begin = load_packed_view_from_file(ceil(log2(n+1)),nr_of_exception_runs,fp);
+			exception_length = load_packed_view_from_file(ceil(log2(n+1)),nr_of_exception_runs,fp);
+			exception_char = load_packed_view_from_file(log_sigma,nr_of_exception_runs,fp);
+
+		}
+
 		numBytes++;//avoids "variable not used" warning
 
 	}
 
-	static DBhash loadFromFile(string path){
+	static DBhash_t loadFromFile(string path){
 
-		DBhash dbh = DBhash();
+		DBhash_t dbh = DBhash_t();
 		dbh.load(path);
 		return dbh;
 
@@ -336,7 +498,237 @@ public:
 			exit(1);
 		}
 
-		return filterOutBadOccurrences(P, getOccurrences(h.hashValue(P)), max_errors);
+		ulint fingerprint = h.hashValue(P);
+
+		if(max_errors==0 and isOverloaded(fingerprint))
+			return filterOutBadOccurrences(P, overloadedCandidates(overloadedIndex(fingerprint),P), 0);
+
+		return filterOutBadOccurrences(P, getOccurrences(fingerprint), max_errors);
+
+	}
+
+	//number of text substrings having the same hash value as P (candidate occurrences, not verified against the text).
+	//Only backward search: no LF walks are performed
+	ulint numberOfOccurrencies(string &P){
+
+		if(P.length()!=m){
+			cerr << "Error: Searching pattern of length " << P.length() << " in a dB-hash with pattern length " << m<<endl;
+			exit(1);
+		}
+
+		return numberOfOccurrences(h.hashValue(P));
+
+	}
+
+	//returns at most max_hits occurrences of P at distance <= max_errors (all of them if max_hits=0). The candidate
+	//occurrences are located and verified in blocks of max_hits, and locate stops as soon as max_hits of them are verified
+	vector<ulint> getOccurrenciesUpTo(string &P, ulint max_hits, uint max_errors=0){
+
+		if(max_hits==0)
+			return getOccurrencies(P,max_errors);
+
+		if(P.length()!=m){
+			cerr << "Error: Searching pattern of length " << P.length() << " in a dB-hash with pattern length " << m<<endl;
+			exit(1);
+		}
+
+		ulint fingerprint = h.hashValue(P);
+
+		vector<ulint> good;
+
+		if(isOverloaded(fingerprint)){//positions are stored: no locate cost
+
+			ulint i = overloadedIndex(fingerprint);
+
+			for(auto occ : filterOutBadOccurrences(P, max_errors==0 ? overloadedCandidates(i,P) : locate(fingerprint,getInterval(fingerprint)), max_errors))
+				if(good.size()<max_hits)
+					good.push_back(occ);
+
+			return good;
+
+		}
+
+		pair<ulint, ulint> interval = getInterval(fingerprint);
+
+		for(ulint i=interval.first;i<interval.second and good.size()<max_hits;i+=max_hits){
+
+			pair<ulint, ulint> block(i, std::min(i+max_hits,interval.second));
+
+			for(auto occ : filterOutBadOccurrences(P, indexedBWT.convertToTextCoordinates(block), max_errors))
+				if(good.size()<max_hits)
+					good.push_back(occ);
+
+		}
+
+		return good;
+
+	}
+
+	/*
+	 * candidate occurrences (sorted, not verified) of a pattern with fingerprint 'fingerprint' and at most max_errors errors.
+	 * Searches h(P) XOR z XOR s for every z in Z(0),...,Z(max_errors) and every s obtained from wildcard_mask by setting some
+	 * of its bits to 0 (see qualityHashFunction). If this requires more than max_probes searches, max_errors is decreased;
+	 * if max_probes is exceeded also with max_errors=0, wildcard_mask is ignored.
+	 */
+	vector<ulint> getCandidates(ulint fingerprint, uint max_errors, ulint wildcard_mask = 0, ulint max_probes = 4096){
+
+		if(max_errors>h.maxErrors())
+			max_errors = h.maxErrors();
+
+		if(popcnt(wildcard_mask)>=63 or (((ulint)1)<<popcnt(wildcard_mask)) > max_probes)
+			wildcard_mask = 0;
+
+		while(max_errors>0){
+
+			ulint nr_of_z = 0;
+
+			for(auto Z = h.getSetZIterator(); Z.hasNext() and Z.getNextErrors()<=max_errors; Z.nextElement())
+				nr_of_z++;
+
+			if((((ulint)1)<<popcnt(wildcard_mask))*nr_of_z <= max_probes)
+				break;
+
+			max_errors--;
+
+		}
+
+		vector<ulint> candidates;
+
+		auto Z = h.getSetZIterator();
+
+		while(Z.hasNext() and Z.getNextErrors()<=max_errors){
+
+			ulint f = fingerprint ^ Z.nextElement();
+
+			ulint s = wildcard_mask;
+
+			while(true){//all subsets s of the wildcard mask
+
+				pair<ulint, ulint> interval = getInterval(f ^ s);
+
+				if(interval.second>interval.first)
+					for(auto occ : locate(f ^ s, interval))
+						candidates.push_back(occ);
+
+				if(s==0)
+					break;
+
+				s = (s-1) & wildcard_mask;
+
+			}
+
+		}
+
+		std::sort(candidates.begin(),candidates.end());
+		candidates.erase( std::unique(candidates.begin(),candidates.end()), candidates.end() );
+
+		return candidates;
+
+	}
+
+	/*
+	 * hash function turning a quality string of length m into a mask of the fingerprint digits affected by characters with
+	 * quality < quality_threshold (Phred+33). These digits can be used as wildcards in getCandidates.
+	 * The quality hash type is QUALITY_BS_SEARCH for base-2 fingerprints, QUALITY_DNA_SEARCH otherwise.
+	 * Returns false if the quality fingerprints are not compatible (different word length or base) with the fingerprints of the index.
+	 */
+	bool qualityHashFunction(uint quality_threshold, HashFunction &qh){
+
+		hash_type type = policy.base()==2 ? QUALITY_BS_SEARCH : QUALITY_DNA_SEARCH;
+
+		qh = HashFunction(n,m,type,quality_threshold);
+
+		return qh.w==h.w and qh.log_base==policy.logBase();
+
+	}
+
+	/*
+	 * approximate search: returns (sorted) all occurrences of P at Hamming distance <= max_errors.
+	 * A mismatch between P and a text substring perturbs the fingerprint of P by an element of the set Z(1) of
+	 * the hash function, so the fingerprints of the occurrences with e errors are h(P) XOR z, for z in Z(0),...,Z(e).
+	 * All these fingerprints are searched, the candidates are deduplicated and then verified against the text.
+	 * max_errors cannot exceed the radius of the Z set of the hash function.
+	 * If stats is not NULL, it is filled with the number of candidates and the search time per error level.
+	 */
+	vector<ulint> getApproximateOccurrencies(string &P, uint max_errors, search_stats * stats = NULL){
+
+	    using std::chrono::high_resolution_clock;
+	    using std::chrono::duration_cast;
+	    using std::chrono::duration;
+
+		if(P.length()!=m){
+			cerr << "Error: Searching pattern of length " << P.length() << " in a dB-hash with pattern length " << m<<endl;
+			exit(1);
+		}
+
+		if(max_errors>h.maxErrors()){
+			cerr << "Error: at most " << h.maxErrors() << " errors are supported by the approximate search" << endl;
+			exit(1);
+		}
+
+		if(stats!=NULL){
+
+			stats->probes = vector<ulint>(max_errors+1,0);
+			stats->candidates = vector<ulint>(max_errors+1,0);
+			stats->locate_ns = vector<double>(max_errors+1,0);
+
+		}
+
+		ulint fingerprint = h.hashValue(P);
+
+		vector<ulint> candidates;
+
+		auto Z = h.getSetZIterator();
+
+		while(Z.hasNext() and Z.getNextErrors()<=max_errors){
+
+			uint e = Z.getNextErrors();
+
+			auto t1 = high_resolution_clock::now();
+
+			ulint f = fingerprint ^ Z.nextElement();
+			pair<ulint, ulint> interval = getInterval(f);
+
+			ulint nr_of_candidates = 0;
+
+			if(interval.second>interval.first){
+
+				for(auto occ : locate(f,interval))
+					candidates.push_back(occ);
+
+				nr_of_candidates = interval.second-interval.first;
+
+			}
+
+			auto t2 = high_resolution_clock::now();
+
+			if(stats!=NULL){
+
+				stats->probes[e]++;
+				stats->candidates[e] += nr_of_candidates;
+				stats->locate_ns[e] += duration_cast<duration<double, std::nano>>(t2 - t1).count();
+
+			}
+
+		}
+
+		auto t1 = high_resolution_clock::now();
+
+		std::sort(candidates.begin(),candidates.end());
+		candidates.erase( std::unique(candidates.begin(),candidates.end()), candidates.end() );
+
+		vector<ulint> good = filterOutBadOccurrences(P, candidates, max_errors);
+
+		auto t2 = high_resolution_clock::now();
+
+		if(stats!=NULL){
+
+			stats->occurrences = good.size();
+			stats->verify_ns = duration_cast<duration<double, std::nano>>(t2 - t1).count();
+
+		}
+
+		return good;
 
 	}
 
@@ -345,6 +737,113 @@ public:
 
 		vector<ulint> good;
 
+		for(auto o : verifyOccurrences(P,occ,max_errors))
+			good.push_back(o.first);
+
+		return good;
+
+	}
+
+	/*
+	 * as filterOutBadOccurrences, but returns pairs <text position, Hamming distance from P>.
+	 * The pattern is packed once with the same width as text_wv; then each candidate is compared one machine word at a time
+	 * (64/text_width characters): the XOR of text and pattern words is folded so that the lowest bit of each field is 1 iff
+	 * the field differs, and the mismatches are counted with a popcount.
+	 * With the packed text format, the exceptions overlapping the candidate are compared one character at a time, and
+	 * the count is corrected before comparing the words (so that the count only grows during the comparison).
+	 * If ignored is not empty, the pattern positions j with ignored[j] (e.g. low-quality bases) are cleared from the masks:
+	 * they are never counted as mismatches.
+	 */
+	vector<pair<ulint, uint> > verifyOccurrences(string &P, vector<ulint> occ, uint max_errors, const vector<bool> &ignored = vector<bool>()){
+
+		ulint length = P.length();
+		uint chars_per_word = 64/text_width;
+		ulint nr_of_words = (length+chars_per_word-1)/chars_per_word;
+
+		//pattern and mask (lowest bit of each field = 1 iff the pattern character is stored in text_wv) packed as the text
+		packed_view_t P_wv(text_width,length);
+		packed_view_t mask_wv(text_width,length);
+
+		ulint missing = 0;//pattern characters that are not stored in text_wv: they are mismatches, except against equal exceptions
+
+		for(ulint j=0;j<length;j++){
+
+			if(not ignored.empty() and ignored[j]){
+
+				P_wv[j] = 0;
+				mask_wv[j] = 0;
+
+			}else if(isPacked((uchar)P[j])){
+
+				P_wv[j] = char_to_int[(uchar)P[j]];
+				mask_wv[j] = 1;
+
+			}else{
+
+				P_wv[j] = 0;
+				mask_wv[j] = 0;
+				missing++;
+
+			}
+
+		}
+
+		vector<ulint> P_words(nr_of_words);
+		vector<ulint> masks(nr_of_words);
+
+		for(ulint k=0;k<nr_of_words;k++){
+
+			ulint begin = k*chars_per_word;
+			ulint end = std::min(begin+chars_per_word,length);
+
+			P_words[k] = P_wv.bits().get(begin*text_width,end*text_width);
+			masks[k] = mask_wv.bits().get(begin*text_width,end*text_width);
+
+		}
+
+		vector<pair<ulint, uint> > good;
+
+		for(ulint i=0;i<occ.size();i++){
+
+			ulint s = occ[i];//shift in text
+
+			if(s+length>n)//the fingerprint text is longer than n-m+1: discard positions not followed by m characters
+				continue;
+
+			ulint dist = missing;
+
+			if(nr_of_exception_runs>0)
+				dist = (long int)missing + exceptionsCorrection(P,s,ignored);
+
+			for(ulint k=0;k<nr_of_words and dist<=max_errors;k++){
+
+				ulint begin = s + k*chars_per_word;
+				ulint end = std::min(begin+chars_per_word,s+length);
+
+				ulint x = text_wv.bits().get(begin*text_width,end*text_width) ^ P_words[k];
+				ulint diff = x;
+
+				for(uint b=1;b<text_width;b++)
+					diff |= x >> b;
+
+				dist += popcnt(diff & masks[k]);
+
+			}
+
+			if(dist<=max_errors)
+				good.push_back(pair<ulint, uint>(s,dist));
+
+		}
+
+		return good;
+
+	}
+
+	//character-by-character version of filterOutBadOccurrences
+	vector<ulint> filterOutBadOccurrences_slow(string &P, vector<ulint> occ, uint max_errors){
+
+		vector<ulint> good;
+
 		ulint dist=0;
 		ulint s;//shift in text
 
@@ -353,6 +852,9 @@ public:
 			dist = 0;
 			s = occ.at(i);
 
+			if(s+P.length()>n)//the fingerprint text is longer than n-m+1: discard positions not followed by m characters
+				continue;
+
 			for(ulint j=0;j<P.length() and dist<=max_errors;j++)
 				if((uchar)P.at(j) != textAt(s+j))
 					dist++;
@@ -369,11 +871,239 @@ public:
 	ulint textLength(){return n;}
 	ulint patternLength(){return m;}
 
-	HashFunction hashFunction(){return h;}
+	HashFunction_t<hash_policy> hashFunction(){return h;}
 
 protected:
 
-	void initText(string &text){
+	//BWT interval of the fingerprint: the auxiliary hash gives the interval of its suffix of length w_aux,
+	//then the remaining prefix is searched with backward search
+	pair<ulint, ulint> getInterval(ulint fingerprint){
+
+		ulint mask = auxiliary_hash_size-1;
+
+		ulint suffix = fingerprint & mask;//suffix of length w_aux. Searched in the auxiliary hash
+		ulint prefix = fingerprint >> (w_aux*policy.logBase());//prefix of the fingerprint of length log m/log base to be searched with backward search
+
+		pair<ulint, ulint> interval;
+
+		interval.first = auxiliary_hash[suffix];
+
+		if (suffix + 1 == auxiliary_hash_size)
+			interval.second = text_fingerprint_length + 1;
+		else
+			interval.second = auxiliary_hash[suffix+1];
+
+		if(interval.second<=interval.first)
+			return interval;
+
+		return indexedBWT.BS(prefix,w-w_aux,interval,policy.logBase());
+
+	}
+
+	bool isOverloaded(ulint fingerprint){return overloadedIndex(fingerprint)<overloaded.size();}
+
+	//index of the fingerprint in the (sorted) overloaded fingerprints, or overloaded.size() if it is not overloaded
+	ulint overloadedIndex(ulint fingerprint){
+
+		auto it = std::lower_bound(overloaded.begin(),overloaded.end(),fingerprint);
+
+		if(it==overloaded.end() or *it!=fingerprint)
+			return overloaded.size();
+
+		return it-overloaded.begin();
+
+	}
+
+	/*
+	 * text positions of the fingerprint with BWT interval 'interval' (at most max_hits of them if max_hits>0). Overloaded
+	 * fingerprints are read from their position list, the others are located with LF walks.
+	 */
+	vector<ulint> locate(ulint fingerprint, pair<ulint, ulint> interval, ulint max_hits = 0){
+
+		ulint i = overloadedIndex(fingerprint);
+
+		if(i<overloaded.size()){
+
+			ulint end = overload_begin[i+1];
+
+			if(max_hits>0 and end-overload_begin[i]>max_hits)
+				end = overload_begin[i]+max_hits;
+
+			vector<ulint> occ;
+
+			for(ulint j=overload_begin[i];j<end;j++)
+				occ.push_back(overload_pos[j]);
+
+			return occ;
+
+		}
+
+		if(max_hits>0 and interval.second>interval.first and interval.second-interval.first>max_hits)//truncate interval
+			interval.second = interval.first+max_hits;
+
+		return indexedBWT.convertToTextCoordinates( interval );
+
+	}
+
+	//key of the text position s: its first key_length characters, packed as in text_wv (exceptions are 0)
+	inline ulint textKey(ulint s){return text_wv.bits().get(s*text_width,(s+key_length)*text_width);}
+
+	/*
+	 * candidates for an exact occurrence of P among the positions of the i-th overloaded fingerprint: only the positions
+	 * whose key is equal to the first key_length characters of P (binary search in the list, which is sorted by key).
+	 */
+	vector<ulint> overloadedCandidates(ulint i, string &P){
+
+		packed_view_t P_wv(text_width,key_length);
+
+		for(ulint j=0;j<key_length;j++){
+
+			if(char_to_int[(uchar)P[j]]>=sigma)//the character does not occur in the text
+				return vector<ulint>();
+
+			P_wv[j] = isPacked((uchar)P[j]) ? char_to_int[(uchar)P[j]] : 0;//as the exceptions in textKey
+
+		}
+
+		ulint key = P_wv.bits().get(0,key_length*text_width);
+
+		ulint a = overload_begin[i];
+		ulint b = overload_begin[i+1];
+
+		while(a<b){//first position with key >= P's key
+
+			ulint c = a+(b-a)/2;
+
+			if(overload_key[c]<key)
+				a = c+1;
+			else
+				b = c;
+
+		}
+
+		vector<ulint> occ;
+
+		for(ulint j=a;j<overload_begin[i+1] and overload_key[j]==key;j++)
+			occ.push_back(overload_pos[j]);
+
+		return occ;
+
+	}
+
+	/*
+	 * stores the text positions of the fingerprints with more than threshold occurrences (found with overloadedFingerprints).
+	 * Positions not followed by m characters are not stored (they cannot be occurrences). The list of each fingerprint
+	 * is sorted by key (the first key_length characters of the text position, at most 32 bits), so that exact queries
+	 * verify only the positions sharing their key with the pattern. The lists are located in parallel.
+	 */
+	void initOverloadIndex(ulint threshold, uint nr_of_threads = 1){
+
+		overload_threshold = threshold;
+
+		key_length = std::min(m,(ulint)(32/text_width));
+
+		auto fingerprints = overloadedFingerprints(threshold);
+
+		vector<vector<pair<ulint, ulint> > > lists(fingerprints.size());//<key, position> pairs
+
+		parallel_for(fingerprints.size(), 1, nr_of_threads, [&](ulint b, ulint e){
+
+			for(ulint i=b;i<e;i++){
+
+				for(auto s : indexedBWT.convertToTextCoordinates(fingerprints[i].second))
+					if(s+m<=n)
+						lists[i].push_back(pair<ulint, ulint>(textKey(s),s));
+
+				std::sort(lists[i].begin(),lists[i].end());
+
+			}
+
+		});
+
+		overloaded.clear();
+		overload_begin = vector<ulint>(1,0);
+
+		for(ulint i=0;i<fingerprints.size();i++){
+
+			overloaded.push_back(fingerprints[i].first);
+			overload_begin.push_back(overload_begin.back()+lists[i].size());
+
+		}
+
+		if(overloaded.size()==0){
+
+			overload_begin.clear();
+			return;
+
+		}
+
+		overload_pos = packed_view_t(ceil(log2(n+1)),overloadedPositions());
+		overload_key = packed_view_t(key_length*text_width,overloadedPositions());
+
+		for(ulint i=0;i<lists.size();i++)
+			for(ulint j=0;j<lists[i].size();j++){
+
+				overload_pos[overload_begin[i]+j] = lists[i][j].second;
+				overload_key[overload_begin[i]+j] = lists[i][j].first;
+
+			}
+
+	}
+
+	/*
+	 * visit the fingerprints (depth-w nodes of the fingerprint trie, digits from the least significant as in backward search)
+	 * whose BWT interval has more than min_size elements, calling visit(fingerprint, interval). 'interval' is the interval of the
+	 * node at depth 'level' with digits 'fingerprint'. Empty subtrees and subtrees with at most min_size elements are not visited.
+	 */
+	template<class F>
+	void fingerprintDFS(pair<ulint, ulint> interval, uint level, ulint fingerprint, ulint min_size, F &visit){
+
+		if(interval.second<=interval.first or interval.second-interval.first<=min_size)
+			return;
+
+		if(level==w){
+
+			visit(fingerprint,interval);
+			return;
+
+		}
+
+		for(ulint d=0;d<(((ulint)1)<<policy.logBase());d++)
+			fingerprintDFS(indexedBWT.BS(interval,(uchar)(d+1)), level+1, fingerprint + (d<<(level*policy.logBase())), min_size, visit);//digits are remapped adding 1
+
+	}
+
+	struct build_phase{
+
+		string name;
+		double seconds;
+		ulint rss;
+		ulint peak_rss;
+
+	};
+
+	std::chrono::high_resolution_clock::time_point phaseStart(){return std::chrono::high_resolution_clock::now();}
+
+	//record the phase started at time t1 and return the start time of the next phase
+	std::chrono::high_resolution_clock::time_point phaseEnd(string name, std::chrono::high_resolution_clock::time_point t1){
+
+		auto t2 = std::chrono::high_resolution_clock::now();
+
+		build_phase p;
+		p.name = name;
+		p.seconds = std::chrono::duration_cast<std::chrono::duration<double, std::ratio<1> > >(t2 - t1).count();
+		size_t rss, peak_rss;
+		getRSS(rss, peak_rss);//same source for both (see extern/getRSS.h), so that peak_rss >= rss
+		p.rss = rss;
+		p.peak_rss = peak_rss;
+
+		build_report.push_back(p);
+
+		return t2;
+
+	}
+
+	void initText(string &text, uint nr_of_threads = 1, text_format format = plain_text){
 
 		char_to_int = vector<uint>(256);
 
@@ -384,6 +1114,9 @@ protected:
 
 		sigma=0;
 
+		vector<ulint> freq(256,0);
+		vector<ulint> runs(256,0);//number of maximal runs of each character
+
 		//compute alphabet size and init codes to convert char to int
 		for(ulint i = 0;i<n;i++){
 
@@ -392,6 +1125,52 @@ protected:
 				sigma++;
 			}
 
+			freq[(uchar)text[i]]++;
+
+			if(i==0 or text[i]!=text[i-1])
+				runs[(uchar)text[i]]++;
+
+		}
+
+		log_sigma = ceil(log2(sigma));
+		if(log_sigma==0) log_sigma=1;
+
+		text_width = log_sigma;
+
+		if(format==packed_text){
+
+			//codes by decreasing frequency: the characters with code >= 2^text_width are exceptions
+			vector<uchar> by_freq;
+
+			for(ulint c=0;c<256;c++)
+				if(char_to_int[c]!=empty)
+					by_freq.push_back(c);
+
+			std::stable_sort(by_freq.begin(),by_freq.end(),[&](uchar a, uchar b){return freq[a]>freq[b];});
+
+			for(ulint i=0;i<sigma;i++)
+				char_to_int[by_freq[i]] = i;
+
+			//choose the width minimizing n*width + (number of exception runs)*(bits per run)
+			ulint bits_per_run = 2*ceil(log2(n+1)) + log_sigma;
+			ulint best = n*log_sigma;
+
+			for(uint width=1;width<log_sigma;width++){
+
+				ulint exception_runs = 0;
+
+				for(ulint i=((ulint)1)<<width;i<sigma;i++)
+					exception_runs += runs[by_freq[i]];
+
+				if(n*width + exception_runs*bits_per_run < best){
+
+					best = n*width + exception_runs*bits_per_run;
+					text_width = width;
+
+				}
+
+			}
+
 		}
 
 		int_to_char = vector<uchar>(sigma);
@@ -403,46 +1182,188 @@ protected:
 
 		}
 
-		log_sigma = ceil(log2(sigma));
-		if(log_sigma==0) log_sigma=1;
+		text_wv =  packed_view_t(text_width,n);
+
+		//chunks of a multiple of 64 characters start at word boundaries of text_wv: threads never write the same word
+		parallel_for(n, 64*1024, nr_of_threads, [&](ulint b, ulint e){
+
+			for(ulint i = b;i<e;i++)
+				text_wv[i] = isPacked((uchar)text[i]) ? char_to_int[(uchar)text[i]] : 0;
+
+		});
+
+		//runs of exceptions
+
+		nr_of_exception_runs = 0;
+
+		for(ulint i=0;i<n;i++)
+			if(not isPacked((uchar)text[i]) and (i==0 or text[i]!=text[i-1]))
+				nr_of_exception_runs++;
+
+		if(nr_of_exception_runs==0)
+			return;
 
-		text_wv =  packed_view_t(log_sigma,n);
+		exception_begin = packed_view_t(ceil(log2(n+1)),nr_of_exception_runs);
+		exception_length = packed_view_t(ceil(log2(n+1)),nr_of_exception_runs);
+		exception_char = packed_view_t(log_sigma,nr_of_exception_runs);
 
-		for(ulint i = 0;i<n;i++)
-			text_wv[i] = char_to_int[(uchar)text.at(i)];
+		ulint r = 0;
+
+		for(ulint i=0;i<n;i++){
+
+			if(isPacked((uchar)text[i]))
+				continue;
+
+			if(i==0 or text[i]!=text[i-1]){
+
+				exception_begin[r] = i;
+				exception_length[r] = 0;
+				exception_char[r] = char_to_int[(uchar)text[i]];
+				r++;
+
+			}
+
+			exception_length[r-1]++;
+
+		}
 
 	}
 
-	void initAuxHash(){
+	//the character is stored in text_wv (otherwise, it is in the exceptions of the packed text or it does not occur in the text)
+	inline bool isPacked(uchar c){return char_to_int[c]<sigma and char_to_int[c]<(((ulint)1)<<text_width);}
+
+	//last exception run starting at or before position i (nr_of_exception_runs if there is none)
+	ulint exceptionRun(ulint i){
+
+		ulint a = 0, b = nr_of_exception_runs;
+
+		while(a<b){//first run starting after i
+
+			ulint c = a+(b-a)/2;
+
+			if(exception_begin[c]<=i)
+				a = c+1;
+			else
+				b = c;
+
+		}
+
+		return a==0 ? nr_of_exception_runs : a-1;
+
+	}
+
+	/*
+	 * difference between the number of mismatches between P and the text at position s, and the number computed by
+	 * verifyOccurrences from text_wv (where exceptions are 0) and the count of pattern characters not in text_wv.
+	 * Ignored pattern positions are not counted by verifyOccurrences, so they need no correction.
+	 */
+	long int exceptionsCorrection(string &P, ulint s, const vector<bool> &ignored){
+
+		long int correction = 0;
+
+		ulint length = P.length();
+		ulint r = exceptionRun(s);
+
+		if(r==nr_of_exception_runs)
+			r = 0;
+
+		for(;r<nr_of_exception_runs and exception_begin[r]<s+length;r++){
+
+			ulint b = std::max((ulint)exception_begin[r],s);
+			ulint e = std::min((ulint)(exception_begin[r]+exception_length[r]),s+length);
+
+			uchar c = int_to_char[exception_char[r]];
+
+			for(ulint i=b;i<e;i++){
+
+				if(not ignored.empty() and ignored[i-s])
+					continue;
+
+				uchar p = P[i-s];
+
+				if(isPacked(p))
+					correction += char_to_int[p]==0;//counted as a match against the 0 stored in text_wv
+				else
+					correction += (p!=c) - 1;//counted as a mismatch in 'missing'
+
+			}
+
+		}
+
+		return correction;
+
+	}
+
+	/*
+	 * entry i of the auxiliary hash is the first BWT position of the w_aux-digits fingerprint i (empty if i does not occur).
+	 * Backward search reads the digits of i from the least significant, so the entries form a trie of depth w_aux: the
+	 * intervals are computed by a depth-first visit of the trie, extending the interval of the parent with one digit
+	 * (one pair of rank operations per trie edge; empty subtrees are not visited).
+	 * With nr_of_threads>1, the subtrees rooted at depth k (the smallest depth with at least 8*nr_of_threads nodes) are visited
+	 * in parallel. The entries of a subtree are not contiguous in the auxiliary hash (they share the k least significant digits),
+	 * so each subtree is visited into a local buffer, and then the buffers are copied in the auxiliary hash.
+	 */
+	void initAuxHash(uint nr_of_threads = 1, bool verbose = true){
 
 		auxiliary_hash =  packed_view_t(ceil(log2(n+1)),auxiliary_hash_size);
 
 		ulint empty = text_fingerprint_length+1;
 
-		int perc,last_perc=-1;
+		uint k = 0;//depth of the roots of the subtrees visited in parallel
 
-		for (ulint i = 0; i < auxiliary_hash_size; i++){
+		if(nr_of_threads>1)
+			while(k<w_aux and (((ulint)1)<<(k*policy.logBase())) < 8*nr_of_threads)
+				k++;
 
-			pair<ulint,ulint> interval = indexedBWT.BS(i,w_aux);
+		if(k==0){
 
-			if(interval.second>interval.first)
-				auxiliary_hash[i] = interval.first;
-			else
-				auxiliary_hash[i] = empty;
+			auto set = [&](ulint i, ulint value){ auxiliary_hash[i] = value; };
+
+			auxHashDFS(pair<ulint, ulint>(0,indexedBWT.length()), 0, 0, 0, set);
+
+		}else{
+
+			ulint nr_of_subtrees = ((ulint)1)<<(k*policy.logBase());
+			ulint subtree_size = auxiliary_hash_size >> (k*policy.logBase());
+
+			vector<vector<ulint> > local(nr_of_threads, vector<ulint>(subtree_size));
+
+			for(ulint first=0;first<nr_of_subtrees;first+=nr_of_threads){
+
+				ulint last = std::min(first+nr_of_threads,nr_of_subtrees);
+
+				parallel_for(last-first, 1, nr_of_threads, [&](ulint b, ulint e){
+
+					for(ulint t=b;t<e;t++){
+
+						ulint subtree = first+t;
+
+						//interval of the k least significant digits of the subtree
+						pair<ulint, ulint> interval(0,indexedBWT.length());
+
+						for(uint l=0;l<k and interval.second>interval.first;l++)
+							interval = indexedBWT.BS(interval,(uchar)(digit(subtree,l)+1));//digits are remapped adding 1
+
+						vector<ulint> &L = local[t];
+						auto set = [&](ulint j, ulint value){ L[j] = value; };
+
+						auxHashDFS(interval, k, 0, k, set);
+
+					}
 
-			perc = (100*i)/auxiliary_hash_size;
-			if(perc>last_perc and perc%10==0){
+				});
 
-				cout << "   " <<  perc << "% done." << endl;
-				last_perc=perc;
+				for(ulint t=0;t<last-first;t++)
+					for(ulint j=0;j<subtree_size;j++)
+						auxiliary_hash[(first+t) + (j<<(k*policy.logBase()))] = local[t][j];
+
+				if(verbose)
+					cout << "   " << (100*last)/nr_of_subtrees << "% done." << endl;
 
 			}
 
 		}
 
-		if (auxiliary_hash[auxiliary_hash_size-1] == empty)
-			auxiliary_hash[auxiliary_hash_size-1] = text_fingerprint_length;
-
 		for (ulint i = auxiliary_hash_size - 1; i >= 1; i--) {
 
 			if (auxiliary_hash[i-1] == empty)
@@ -450,6 +1371,64 @@ protected:
 
 		}
 
+	#ifdef DEBUG
+		//the last entries (all low digits maximal, and the ones before them up to the last non-empty entry) end at the BWT length
+		for (ulint i = auxiliary_hash_size; i >= 1; i--) {
+
+			pair<ulint, ulint> expected = indexedBWT.BS(i-1,w_aux,pair<ulint, ulint>(0,indexedBWT.length()),policy.logBase());
+			ulint end = i == auxiliary_hash_size ? text_fingerprint_length + 1 : auxiliary_hash.get(i);
+
+			bool ok = expected.second>expected.first ? (auxiliary_hash.get(i-1)==expected.first and end==expected.second) : end<=auxiliary_hash.get(i-1);
+
+			if(not ok){
+				cout << "ERROR (DBhash): wrong auxiliary hash interval for the suffix " << i-1 << "\n";
+				exit(0);
+			}
+
+			if(expected.second>expected.first)
+				break;
+
+		}
+	#endif
+
+	}
+
+	//i-th digit (from the least significant) of the fingerprint W
+	inline uint digit(ulint W, uint i){return (W >> (i*policy.logBase())) & ((((ulint)1)<<policy.logBase())-1);}
+
+	/*
+	 * visit the subtree of the auxiliary hash trie whose root has depth 'level' and BWT interval 'interval'.
+	 * j = digits of the path from depth root_level to the root of the subtree. For each entry of the subtree, calls
+	 * set(j + (digits below the root << ...), value), where entries are numbered from the digits of depth >= root_level.
+	 */
+	template<class F>
+	void auxHashDFS(pair<ulint, ulint> interval, uint level, ulint j, uint root_level, F &set){
+
+		ulint shift = (level-root_level)*policy.logBase();
+
+		//empty subtree: all its entries are empty. The empty value n+1 is the BWT length, so that after the backward fill in
+		//initAuxHash the last non-empty entry ends at the last BWT row (see getInterval)
+		if(interval.second<=interval.first){
+
+			ulint count = ((ulint)1)<<((w_aux-level)*policy.logBase());
+
+			for(ulint x=0;x<count;x++)
+				set(j + (x<<shift), text_fingerprint_length+1);
+
+			return;
+
+		}
+
+		if(level==w_aux){
+
+			set(j, interval.first);
+			return;
+
+		}
+
+		for(ulint d=0;d<(((ulint)1)<<policy.logBase());d++)
+			auxHashDFS(indexedBWT.BS(interval,(uchar)(d+1)), level+1, j + (d<<shift), root_level, set);//digits are remapped adding 1
+
 	}
 
 	ulint n,m,w;//text length, pattern length, word length
@@ -459,13 +1438,30 @@ protected:
 
 	ulint text_fingerprint_length;
 
-	HashFunction h;
+	HashFunction_t<hash_policy> h;
+	hash_policy policy;//policy of h: the digit loops read base and log_base from it (constants for static policies)
 	ulint offrate;
 
 	IndexedBWT indexedBWT;
-	packed_view_t text_wv;//the plain text
+	packed_view_t text_wv;//the text (in packed format, the exceptions are 0)
+
+	uint text_width;//bits per character of text_wv: log_sigma in plain format
+
+	ulint nr_of_exception_runs = 0;//runs of characters not stored in text_wv (packed format)
+	packed_view_t exception_begin;//first text position of each run
+	packed_view_t exception_length;//length of each run
+	packed_view_t exception_char;//character (code) of each run
 	packed_view_t auxiliary_hash;
 
+	ulint overload_threshold = 0;//fingerprints with more than overload_threshold occurrences have a position list (0 = none)
+	vector<ulint> overloaded;//overloaded fingerprints (sorted)
+	vector<ulint> overload_begin;//positions of overloaded[i] are overload_pos[overload_begin[i],...,overload_begin[i+1]-1]
+	packed_view_t overload_pos;//text positions of the overloaded fingerprints, sorted by key within each fingerprint
+	packed_view_t overload_key;//key of each position in overload_pos (see textKey)
+	uint key_length = 0;//number of characters in a key
+
+	vector<build_phase> build_report;//time and memory of the construction phases
+
 	uint sigma;//alphabet size
 	uint log_sigma;//log2(sigma)
 
@@ -474,5 +1470,7 @@ protected:
 
 };
 
+typedef DBhash_t<runtime_hash_policy> DBhash;
+
 } /* namespace data_structures */
 #endif /* DBHASH_H_ */
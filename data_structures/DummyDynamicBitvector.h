@@ -74,6 +74,34 @@ public:
 
 	}
 
+	//remove the bit in position i. Returns the removed bit
+	bool remove(ulint i){
+
+		if(i>=current_size){
+			cout << "ERROR (DummyDynamicBitvector): remove in position " << i << " >= current size of the bitvector (" <<  current_size << ")\n";
+			exit(1);
+		}
+
+		bool x = bitvector.at(i);
+
+		for(ulint j = i;j+1<current_size;j++)
+			bitvector.at(j) = bitvector.at(j+1);
+
+		current_size--;
+
+		return x;
+
+	}
+
+	void set(ulint i, bool x){
+
+		if(i>=current_size)
+			cout << "WARNING: set in position " << i << " >= current size of the bitvector (" <<  current_size << ")\n";
+
+		bitvector.at(i) = x;
+
+	}
+
 	void print(){
 
 		for(ulint i=0;i<size();i++)
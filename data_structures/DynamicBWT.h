@@ -21,8 +21,11 @@
 // Description : Dynamic (only append) compressed BWT.
 
 /*
- * Zero-order Huffman-compressed dynamic BWT. Initialized using absolute symbol frequencies (you need to know final text size and symbol frequencies).
+ * Zero-order Huffman-compressed dynamic BWT. Initialized using absolute symbol frequencies (you need to know final text size and symbol frequencies,
+ * or an upper bound: the BWT can be re-encoded with larger frequencies with reencode()).
  * Then, this class permits to update the BWT by left-extending the text, to do backward search, and to locate positions on the BWT.
+ * With a bitvector type supporting remove (packed_dynamic_bitvector, see sliding_bwt_t), the last character of the text can
+ * be removed (remove_last): extend + remove_last maintain the BWT of a sliding window of a stream.
  * Alphabet is numeric: {0,...,|freq|-1}, where freq is the input frequency vector
  *
  * Complexity is n log n H_0 for insert/access, sample_rate*log n for locate.
@@ -36,7 +39,10 @@
 
 #include "../common/common.h"
 #include "DynamicString.h"
+#include "PartialSums.h"
 #include "dynamic_vector.h"
+#include "packed_dynamic_vector.h"
+#include "packed_dynamic_bitvector.h"
 
 namespace bwtil {
 
@@ -68,17 +74,19 @@ public:
 		current_size=1;//only terminator
 		terminator_pos=0;
 
-		//cumulative number of characters
-		F = vector<ulint>(sigma,1);
+		//cumulative number of characters (+1: the terminator)
+		F_ = PartialSums(sigma,n);
+		F_.setBaseCounter();
 
 		/*
 		 * init structures for dynamic SA sampling
 		 */
 		if(sample_rate>0){
 
-			number_of_samples = n/sample_rate + (n%sample_rate>0) + 1;//first text position always sampled
+			number_of_samples = n/sample_rate + (n%sample_rate>0) + 1;//+1: the terminator
 			sampled_positions = dynamic_bitvector_type(n);
 			sa_samples = dynamic_vector_type(number_of_samples,number_of_bits(n));
+			sample_mask = number_of_bits(n)<64 ? (ulint(1)<<number_of_bits(n))-1 : ~ulint(0);
 
 			//position containing terminator is sampled.
 			sampled_positions.insert(0,true);
@@ -97,8 +105,10 @@ public:
 
 		assert(interval.first <= size() and interval.second <= size());
 
-		interval.first = F[s] + rank(s,interval.first);
-		interval.second = F[s] + rank(s,interval.second);
+		ulint f = F(s);
+
+		interval.first = f + rank(s,interval.first);
+		interval.second = f + rank(s,interval.second);
 
 		return interval;
 
@@ -145,38 +155,77 @@ public:
 	//update BWT by left-extending text with character s
 	ulint extend(symbol s){
 
-		//insert in position terminator_pos character s
-		ds.insert(s,terminator_pos);
+		//insert in position terminator_pos character s. Update terminator position
+		//(insert returns the rank of s at terminator_pos)
+		terminator_pos = F(s) + ds.insert(s,terminator_pos);
 
-		//update terminator position
-		terminator_pos = F[s] + ds.rank(s,terminator_pos);
+		//update F: F(c) is incremented for all c>s
+		F_.increment(s);
 
-		//update F
-		for(ulint i=s+1;i<sigma;i++)
-			F[i]++;
+		sample();
 
-		//update samples
-		if(sample_rate>0){
+		return terminator_pos;
 
-			//check if this position has to be sampled
-			//first text position is always sampled
-			bool sampled = ((current_size%sample_rate)==0) or current_size==n-1;
+	}
 
-			//always update bitvector
-			sampled_positions.insert(terminator_pos,sampled);
+	/*
+	 * left-extend the text with S[0], S[1], ..., S[len-1] (in this order). Returns the final terminator position.
+	 * The cumulative counts of the batch are kept in a Fenwick tree of sigma counters (O(log sigma) per character)
+	 * and added to F once at the end of the batch (one update per distinct symbol of the batch).
+	 */
+	ulint extend_batch(const symbol * S, ulint len){
 
-			//update dynamic vector only if the position is sampled
-			if(sampled)
-				sa_samples.insert( sampled_positions.rank(terminator_pos,true), current_size );
+		//batch_counts: Fenwick tree, prefix sum up to s = number of characters < s inserted in this batch
+		vector<ulint> batch_counts(sigma+1,0);
+		vector<ulint> freq(sigma,0);
+
+		for(ulint k=0;k<len;k++){
+
+			symbol s = S[k];
+			assert(s<sigma);
+
+			ulint less = 0;//number of characters < s in the batch
+			for(ulint j=s;j>0;j-=j&(~j+1))
+				less += batch_counts[j];
+
+			terminator_pos = F(s) + less + ds.insert(s,terminator_pos);
+
+			for(ulint j=s+1;j<=sigma;j+=j&(~j+1))
+				batch_counts[j]++;
+
+			freq[s]++;
+
+			sample();
 
 		}
 
-		current_size++;
+		//update F: F(c) += number of characters < c in the batch
+		for(ulint s=0;s<sigma;s++)
+			if(freq[s]>0)
+				F_.increment(s,freq[s]);
 
 		return terminator_pos;
 
 	}
 
+	/*
+	 * adjusted access and rank in one descent of the wavelet tree: returns <access(i), rank(access(i),i)>.
+	 * If i is the terminator position, returns <sigma,0>
+	 */
+	pair<symbol,ulint> access_rank(ulint i){
+
+		assert(i<current_size);
+
+		if(i<terminator_pos)
+			return ds.access_rank(i);
+
+		if(i==terminator_pos)
+			return {sigma,0};
+
+		return ds.access_rank(i-1);
+
+	}
+
 	/*
 	 * LF function: map from position on BWT to position on F column
 	 */
@@ -184,13 +233,13 @@ public:
 
 		assert(i<current_size);
 
-		symbol s = access(i);
+		auto sr = access_rank(i);
 
-		//if the symbol is terminato, then on F column position is 0
-		if(s==sigma)
+		//if the symbol is terminator, then on F column position is 0
+		if(sr.first==sigma)
 			return 0;
 
-		return F[ s ] + rank(s,i);
+		return F(sr.first) + sr.second;
 
 	}
 
@@ -203,15 +252,7 @@ public:
 	 */
 	ulint locate(ulint i){
 
-		assert(sample_rate>0);
-
-		if(i==terminator_pos)
-			return 0;
-
-		if(sampled_positions[i])
-			return current_size - sa_samples[sampled_positions.rank(i,true)] -1;
-
-		return locate(LF(i))+1;
+		return current_size - 1 - locate_right(i);
 
 	}
 
@@ -226,20 +267,346 @@ public:
 
 		assert(sample_rate>0);
 
-		if(i==terminator_pos)
-			return current_size-1;
+		ulint steps = 0;//number of LF steps: the text position decreases by 1 at each step
+
+		while(true){
+
+			if(i==terminator_pos)
+				return current_size-1-steps;
+
+			if(sampled_positions[i])
+				return sample_value(sampled_positions.rank(i,true)) - steps;
+
+			i = LF(i);
+			steps++;
+
+		}
+
+	}
+
+	/*
+	 * locate many positions at once (see locate). The LF walks of all the positions are advanced in lock-step, one
+	 * step of each walk per round, so that the accesses of different walks are independent and can overlap.
+	 */
+	vector<ulint> locate(const vector<ulint> & positions){
+
+		vector<ulint> result = locate_right(positions);
+
+		for(auto & r : result)
+			r = current_size - 1 - r;
 
-		if(sampled_positions[i])
-			return sa_samples[sampled_positions.rank(i,true)];
+		return result;
 
-		return locate_right(LF(i)) - 1 ;
+	}
+
+	/*
+	 * locate_right many positions at once (see locate_right and locate)
+	 */
+	vector<ulint> locate_right(const vector<ulint> & positions){
+
+		assert(sample_rate>0);
+
+		vector<ulint> result(positions.size());
+
+		vector<ulint> active;//indexes (in positions) of the walks that have not reached a sample
+		vector<ulint> current = positions;//current BWT position of each walk
+
+		for(ulint k=0;k<positions.size();k++)
+			active.push_back(k);
+
+		ulint steps = 0;
+
+		while(active.size()>0){
+
+			ulint still_active = 0;
+
+			for(auto k : active){
+
+				ulint i = current[k];
+
+				if(i==terminator_pos){
+
+					result[k] = current_size-1-steps;
+
+				}else if(sampled_positions[i]){
+
+					result[k] = sample_value(sampled_positions.rank(i,true)) - steps;
+
+				}else{
+
+					current[k] = LF(i);
+					active[still_active++] = k;
+
+				}
+
+			}
+
+			active.resize(still_active);
+			steps++;
+
+		}
+
+		return result;
 
 	}
 
+	/*
+	 * right-contraction: remove the last character of the text, i.e. the first character that was inserted with extend
+	 * (the oldest one). After the call, the BWT, F, locate and locate_right are those of the text without its last
+	 * character. The bitvector and vector types must support remove (e.g. packed_dynamic_bitvector and
+	 * packed_dynamic_vector: see sliding_bwt_t).
+	 *
+	 * Let T = Wx and row 0 be the suffix $, so that x = L[0]. The row of the suffix x$ (LF(0)) is removed and L[0]
+	 * becomes the character preceding x. Removing x changes the suffixes of T that end with x, and their order can
+	 * change: their rows are then moved, from the longest-but-one to the longest, to the position computed with LF
+	 * on the updated BWT, until a row is already in its position (then also the rows of the preceding suffixes are;
+	 * see M. Salson et al., "A four-stage algorithm for updating a Burrows-Wheeler transform", TCS 2009).
+	 * Cost: O(L+1) row moves (each a remove and an insert in the dynamic string), where L is the number of suffixes
+	 * whose order changes: at most the length of the longest suffix of W that occurs also elsewhere in W.
+	 */
+	void remove_last(){
+
+		assert(current_size>1);
+
+		symbol x = access(0);
+		ulint r = LF(0);//row of the suffix x$
+
+		if(r==terminator_pos){
+
+			//the text is x: only the terminator is left
+			ds.remove(0);
+			remove_sample(r);
+			F_.decrement(x);
+
+			terminator_pos = 0;
+
+		}else{
+
+			ulint cur = LF(r);//row of the suffix preceding x$ in text order (that is, yx$)
+
+			//remove row r and replace x with y in row 0 (the suffix y$ is the smallest suffix starting with y)
+			symbol y = ds.remove(r<terminator_pos ? r : r-1);
+			remove_sample(r);
+
+			if(r<terminator_pos) terminator_pos--;
+			if(cur>r) cur--;
+
+			ds.set(0,y);
+			F_.decrement(x);
+
+			//reorder: p is the row of the suffix following the one in row cur, already in its final position
+			ulint p = 0;
+
+			while(true){
+
+				auto cr = access_rank(p);
+				ulint expected = F(cr.first) + cr.second;
+
+				if(expected==cur)
+					break;
+
+				bool last = cur==terminator_pos;//the whole text: no preceding suffix
+
+				//row of the preceding suffix: LF(cur), but if its first character is also cr.first, then LF does not
+				//know that the row in cur belongs to the character in p: exclude it from the rank and from the rows
+				auto cr_cur = access_rank(cur);
+				ulint next = last ? 0 : F(cr_cur.first) + cr_cur.second;
+
+				if(not last and cr_cur.first==cr.first){
+
+					if(p<cur) next--;
+					if(next>=cur) next++;
+
+				}
+
+				move_row(cur, expected);
+
+				if(last)
+					break;
+
+				if(next>cur) next--;
+				if(next>=expected) next++;
+
+				p = expected;
+				cur = next;
+
+			}
+
+		}
+
+		removed++;
+		current_size--;
+
+		//the sample of the suffix $ must stay 0
+		if(sample_rate>0)
+			sa_samples.set(0, stored_sample(0));
+
+	}
+
+	//number of characters removed with remove_last
+	ulint numberOfRemovedCharacters(){ return removed; }
+
 	ulint getMaxLength(){ return n; }
 
+	/*
+	 * F column: number of characters smaller than s in the BWT, terminator included. O(log sigma / log log n) time
+	 */
+	ulint F(symbol s){
+
+		assert(s<sigma);
+		return F_.getCount(s);
+
+	}
+
+	/*
+	 * re-encode the BWT with new absolute frequencies of the characters: the Huffman shape of the dynamic string and
+	 * the capacities of the structures follow freq, while the BWT (and thus all BWT positions and intervals) does not change.
+	 * freq[s] must be at least the number of characters s currently in the BWT. Cost: O(size()) accesses and appends.
+	 */
+	void reencode(vector<ulint> freq){
+
+		assert(freq.size()==sigma);
+
+		ulint new_n = 1;//terminator
+		for(ulint i=0;i<freq.size();i++)
+			new_n += freq[i];
+
+		assert(new_n>=current_size);
+
+		DynamicString<dynamic_bitvector_type> new_ds(freq);
+
+		for(ulint i=0;i<ds.size();i++)
+			new_ds.insert(ds.access(i),i);
+
+		ds = new_ds;
+
+		//the counters of F must hold values up to new_n
+		PartialSums new_F(sigma,new_n);
+		new_F.setBaseCounter();
+
+		for(ulint s=1;s<sigma;s++)
+			new_F.increment(s-1,F(s)-F(s-1));
+
+		F_ = new_F;
+
+		if(sample_rate>0){
+
+			ulint new_number_of_samples = new_n/sample_rate + (new_n%sample_rate>0) + 1;
+
+			dynamic_bitvector_type new_sampled_positions(new_n);
+			dynamic_vector_type new_sa_samples(new_number_of_samples,number_of_bits(new_n));
+
+			for(ulint i=0;i<current_size;i++)
+				new_sampled_positions.insert(i,sampled_positions[i]);
+
+			ulint new_sample_mask = number_of_bits(new_n)<64 ? (ulint(1)<<number_of_bits(new_n))-1 : ~ulint(0);
+
+			for(ulint i=0;i<sa_samples.size();i++)
+				new_sa_samples.insert(i,(sample_value(i)+removed) & new_sample_mask);
+
+			sampled_positions = new_sampled_positions;
+			sa_samples = new_sa_samples;
+			number_of_samples = new_number_of_samples;
+			sample_mask = new_sample_mask;
+
+		}
+
+		n = new_n;
+
+	}
+
 private:
 
+	//update the SA samples after the insertion of the current text position in terminator_pos
+	void sample(){
+
+		if(sample_rate>0){
+
+			//check if this position has to be sampled (the sample rate is on the positions counted with the removed characters).
+			//The first text position needs no sample: its row is the terminator position (see locate_right). A sample forced
+			//at size n-1 would be taken at every extend of a full sliding window, and overflow sa_samples
+			bool sampled = ((current_size+removed)%sample_rate)==0;
+
+			//always update bitvector
+			sampled_positions.insert(terminator_pos,sampled);
+
+			//update dynamic vector only if the position is sampled
+			if(sampled)
+				sa_samples.insert( sampled_positions.rank(terminator_pos,true), stored_sample(current_size) );
+
+		}
+
+		current_size++;
+
+	}
+
+	/*
+	 * SA samples are stored increased by the number of removed characters (modulo 2^width of the samples): removing
+	 * the last character decreases all positions by 1, and the stored samples do not need to be updated.
+	 */
+	ulint sample_value(ulint k){ return (sa_samples[k] - removed) & sample_mask; }
+	ulint stored_sample(ulint position){ return (position + removed) & sample_mask; }
+
+	//remove the sampled-position mark of row r, and its sample
+	void remove_sample(ulint r){
+
+		if(sample_rate==0)
+			return;
+
+		if(sampled_positions[r])
+			sa_samples.remove(sampled_positions.rank(r,true));
+
+		sampled_positions.remove(r);
+
+	}
+
+	/*
+	 * move row from to position to (position of the row after the move): its character and its sample
+	 */
+	void move_row(ulint from, ulint to){
+
+		if(from==terminator_pos){
+
+			//the other rows keep their order: ds does not change
+			terminator_pos = to;
+
+		}else{
+
+			symbol c = ds.remove(from<terminator_pos ? from : from-1);
+
+			if(from<terminator_pos) terminator_pos--;
+
+			if(to<=terminator_pos){
+
+				ds.insert(c,to);
+				terminator_pos++;
+
+			}else{
+
+				ds.insert(c,to-1);
+
+			}
+
+		}
+
+		if(sample_rate>0){
+
+			bool sampled = sampled_positions[from];
+			ulint value = 0;
+
+			if(sampled)
+				value = sa_samples.remove(sampled_positions.rank(from,true));
+
+			sampled_positions.remove(from);
+			sampled_positions.insert(to,sampled);
+
+			if(sampled)
+				sa_samples.insert(sampled_positions.rank(to,true), value);
+
+		}
+
+	}
+
 	DynamicString<dynamic_bitvector_type> ds;
 	ulint n=0;//length of ds + 1 (terminator)
 	ulint terminator_pos=0;
@@ -248,16 +615,21 @@ private:
 
 	ulint sigma=0;//alphabet size and value of terminator
 
-	vector<ulint> F;
+	PartialSums F_;//F column: F_.getCount(s) = 1 + number of characters < s
 
 	ulint sample_rate = 0;
 	ulint number_of_samples=0;
 	dynamic_bitvector_type sampled_positions;//mark with a 1 sampled positions
 	dynamic_vector_type sa_samples;//sampled SA pointers. Note: positions start from the end of the text, with last character having position 1 and terminator having position 0
+	ulint sample_mask = ~ulint(0);//samples are stored modulo sample_mask+1 (see sample_value)
+
+	ulint removed = 0;//number of characters removed with remove_last
 
 };
 
 typedef DynamicBWT<bitv,dynamic_vector_t> dynamic_bwt_t;
+typedef DynamicBWT<bitv,packed_dynamic_vector> packed_dynamic_bwt_t;//SA samples in a B-tree of packed integers
+typedef DynamicBWT<packed_dynamic_bitvector,packed_dynamic_vector> sliding_bwt_t;//supports remove_last
 
 } /* namespace bwtil */
 #endif /* BWTIL_DYNAMICBWT_H_ */
@@ -198,10 +198,52 @@ public:
 
 	}
 
-	void insert(symbol x, ulint i){
+	/*
+	 * access and rank in one descent of the wavelet tree (inverse select): returns <x,rank(x,i)>, with x = access(i).
+	 */
+	pair<symbol,ulint> access_rank(ulint i){
 
 		if(n==0)
-			return;
+			return {0,0};
+
+	#ifdef DEBUG
+		if(i>=current_size){
+
+			cout << "ERROR (DynamicString): trying to access position outside current string : " << i << ">=" << current_size << endl;
+			exit(0);
+
+		}
+	#endif
+
+		if(unary_string)
+			return {s,i};
+
+		uint node = 0;
+
+		while(true){
+
+			bool bit = wavelet_tree[node].access(i);
+			i = wavelet_tree[node].rank(i,bit);
+
+			uint next_node = (bit==0?child0[node]:child1[node]);
+
+			if(next_node>=sigma)//next node is leaf: return symbol and rank
+				return {next_node-sigma, i};
+
+			node = next_node;
+
+		}
+
+	}
+
+	/*
+	 * insert x in position i. Returns the number of x before position i (i.e. rank(x,i)), computed on the same
+	 * root-to-leaf path of the insertion.
+	 */
+	ulint insert(symbol x, ulint i){
+
+		if(n==0)
+			return 0;
 
 	#ifdef DEBUG
 		if(i>current_size){
@@ -223,14 +265,83 @@ public:
 	#endif
 
 
+		ulint r = i;
+
+		if(not unary_string)
+			r = insert(&codes[x],0,0,i);
+
+		current_size++;
+
+		return r;
+
+	}
+
+	/*
+	 * remove the symbol in position i. Returns the removed symbol.
+	 * The bitvector type must support remove (e.g. packed_dynamic_bitvector)
+	 */
+	symbol remove(ulint i){
+
+		if(n==0)
+			return 0;
+
+	#ifdef DEBUG
+		if(i>=current_size){
+
+			cout << "ERROR (DynamicString): trying to remove position outside current string : " << i << ">=" << current_size << endl;
+			exit(0);
+
+		}
+	#endif
+
+		symbol x = s;
+
 		if(not unary_string){
 
-			vector<bool> code = codes.at(x);//bitvector to be inserted in the wavelet tree
-			insert(&code,0,0,i);
+			uint node = 0;
+
+			while(true){
+
+				bool bit = wavelet_tree[node].access(i);
+				ulint next_i = wavelet_tree[node].rank(i,bit);
+
+				wavelet_tree[node].remove(i);
+
+				uint next_node = (bit==0?child0[node]:child1[node]);
+
+				if(next_node>=sigma){//next node is leaf
+
+					x = next_node-sigma;
+					break;
+
+				}
+
+				node = next_node;
+				i = next_i;
+
+			}
 
 		}
 
-		current_size++;
+	#ifdef DEBUG
+		current_freqs.at(x) -= 1;
+	#endif
+
+		current_size--;
+
+		return x;
+
+	}
+
+	/*
+	 * substitute the symbol in position i with x. Returns the old symbol
+	 */
+	symbol set(ulint i, symbol x){
+
+		symbol old = remove(i);
+		insert(x,i);
+
+		return old;
 
 	}
 
@@ -341,7 +452,8 @@ private:
 
 	}
 
-	inline void insert(vector<bool> * code, uint node, uint pos, ulint i){
+	//returns the rank of the code at position i in the last node (= rank of the symbol)
+	inline ulint insert(vector<bool> * code, uint node, uint pos, ulint i){
 
 		bool bit = code->at(pos);
 
@@ -349,17 +461,19 @@ private:
 
 		wavelet_tree[node].insert( i, bit );
 
+		//ulint next_i = wavelet_tree[node].rank(bit,i);
+		ulint next_i = wavelet_tree[node].rank(i,bit);
+
 		if(pos+1<code->size()){
 
 			uint next_node = (bit==0?child0[node]:child1[node]);//find next node
 
-			//ulint next_i = wavelet_tree[node].rank(bit,i);
-			ulint next_i = wavelet_tree[node].rank(i,bit);
-
-			insert(code, next_node, pos+1, next_i);
+			return insert(code, next_node, pos+1, next_i);
 
 		}
 
+		return next_i;
+
 	}
 
 	inline symbol access(uint node, ulint i){
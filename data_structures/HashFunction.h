@@ -25,19 +25,21 @@
 #define HASHFUNCTION_H_
 
 #include "../common/common.h"
+#include "HashPolicies.h"
 #include <sstream>
 #include <fstream>
 
 namespace bwtil {
 
-class HashFunction {
+template<class hash_policy>
+class HashFunction_t {
 public:
 
 	class SetZIterator{
 
 	public:
 
-		SetZIterator(HashFunction * f){
+		SetZIterator(HashFunction_t * f){
 			Z = f->Z.data();
 			Z_size = f->Z_size.data();
 			current_errors=0;
@@ -84,70 +86,35 @@ public:
 	//n = text length, m= pattern length. w is automatically calculated as w = log_b(mn), where b = base (which depends on type)
 	//WARNING: use DNA_SEARCH or BS_SEARCH as hash type only if the text is on the alphabet {A,C,G,T,N}
 	//quality_threshold is meaningful only for QUALITY hash types
-	HashFunction(ulint n, ulint m, hash_type type=DEFAULT, uint quality_threshold=15, bool verbose = false){
+	HashFunction_t(ulint n, ulint m, hash_type type=DEFAULT, uint quality_threshold=15, bool verbose = false){
 
 		if(verbose)
 			cout << "\nBuilding hash function ... \n";
 
-		this->type = type;
-		this->m=m;
+		policy = hash_policy(type,quality_threshold);
 
-		code = vector<uint>(256,0);
-		random_char = vector<uchar>(256,false);
+		init(n,m,policy.base(),verbose);
 
-		if(type == DEFAULT)
-			init_DEFAULT();
-
-		if(type == DNA_SEARCH)
-			init_DNA_SEARCH();
-
-		if(type == BS_SEARCH)
-			init_BS_SEARCH();
-
-		if(type == QUALITY_DNA_SEARCH)
-			init_QUALITY_DNA_SEARCH(quality_threshold);
-
-		if(type == QUALITY_BS_SEARCH)
-			init_QUALITY_BS_SEARCH(quality_threshold);
-
-		w = ceil(log2(m*n)/log2(base));//optimal word size
-
-		//w must not exceed m!
-		if(w>m) w=m;
-
-		log_base = ceil(log2(base));
-		r = m%w;
-
-		if(verbose) cout << " File length : n = " << n<<endl;
-
-		if(verbose)	cout << " Pattern length : m = " << m<<endl;
-
-		if(verbose)	cout << " Alphabet size : sigma = " << base<<endl;
-
-		if(verbose)	cout << " Fingerprints base : b = " << (1<<log_base)<< " (" << log_base << " bits per digit)" << endl;
+	}
 
-		if(verbose)	cout << " Optimal word length : w = " << w<<endl << " Building Z set ... ";
+	//hash function with the given (compile-time) policy, e.g. HashFunction_t<dna_hash_policy>(n,m,dna_hash_policy())
+	HashFunction_t(ulint n, ulint m, hash_policy policy, bool verbose = false){
 
-		buildZSet();
+		if(verbose)
+			cout << "\nBuilding hash function ... \n";
 
-		if(verbose)	cout << "Done." <<endl;
+		this->policy = policy;
 
-		if(verbose)	cout << "Done." <<endl;
+		init(n,m,policy.base(),verbose);
 
 	}
 
-	HashFunction(){}
+	HashFunction_t(){}
 
-	HashFunction(ulint m, string file_path, bool verbose = false){
+	HashFunction_t(ulint m, string file_path, bool verbose = false){
 
 		if(verbose)	cout << "\nBuilding hash function ... \n";
 
-		this->type = DEFAULT;
-		this->m=m;
-
-		code = vector<uint>(256,0);
-		random_char = vector<uchar>(256,false);
-
 		ulint n=0;
 
 		if(verbose)	cout << " Reading input file for detecting alphabet size and file length ... \n";
@@ -183,81 +150,29 @@ public:
 			exit(1);
 		}
 
-		log_base = ceil(log2(alphabet.size()));
-
-		if(log_base>=8)
-			log_base=7;//max 7 bits per digit allowed, since value 255 is forbidden
-
-		base = ((ulint)1)<<log_base;
-
-		//sort alphabet
-
-		std::sort(alphabet.begin(),alphabet.end());
-
-		//calculate code
-
-		for(uint i=0;i<alphabet.size();i++)
-			code[alphabet.at(i)] = i%base;
-
 		fin.close();
 
-		if(verbose)	cout << " File length : n = " << n<<endl;
-
-		if(verbose)	cout << " Pattern length : m = " << m<<endl;
-
-		w = ceil(log2(m*n)/log_base);//optimal word size
-
-		//w must not exceed m!
-		if(w>m) w=m;
-
-		r = m%w;
-
-		if(verbose)	cout << " Alphabet size : sigma = " << alphabet.size() << endl;
-
-		if(verbose)	cout << " Fingerprints base : b = " << base << " (" << log_base << " bits per digit)" << endl;
-
-		if(verbose) cout << " Optimal word length : w = " << w<<endl << " Building Z set ... ";
-
-		buildZSet();
-
-		if(verbose)	cout << "Done." <<endl;
+		policy = hash_policy(alphabet);
 
-		if(verbose)	cout << "Done." <<endl;
+		init(n,m,alphabet.size(),verbose);
 
 	}
 
 	ulint hashValue(string &P){//compute fingerprint of pattern P of length m.
 
-		if(type==QUALITY_DNA_SEARCH or type==QUALITY_BS_SEARCH)
+		if(policy.quality())
 			return qualityHashValue(P);
 
 		assert(P.size()==m);
 
-		ulint W = 0;
 		ulint result = 0;
 
-		for(uint i=0;i<m-r;i++){
-
-			if(i%w==0){
-				result = result^W;
-				W = 0;
-			}
-
-			W = (W<<log_base) + code[(uchar)P.at(i)];
-
-		}
+		for(uint j=0;j<(m-r)/w;j++)
+			if(policy.useBlock(j))
+				result = result^blockValue(P,j*w);
 
-		result = result^W;
-		W = 0;
-
-		if(r>0){
-
-			for(uint i=m-w;i<m;i++)
-				W = (W<<log_base) + code[(uchar)P.at(i)];
-
-			result = result^W;
-
-		}
+		if(r>0 and policy.useBlock((m-r)/w))
+			result = result^blockValue(P,m-w);
 
 		return result;
 
@@ -266,95 +181,66 @@ public:
 	/*
 	 * compute hash value of string P having length >= m
 	 * return hash value where 1 is added to each digit. No 0x0 terminator is appended at the end.
-	 * NB: this function is not yet implemented for QUALITY hash values.
+	 * The digits of random characters are pseudo-random but deterministic given the seed (see setSeed).
+	 * For QUALITY hash types, P is a quality string and the blocks are ORed instead of XORed (as in qualityHashValue).
 	 */
-	string hashValueRemapped(string &P){
-
-		if(type==QUALITY_DNA_SEARCH or type==QUALITY_BS_SEARCH){
-			cout << "Error: hash value remapped not yet implemented for quality hash functions." << endl;
-			exit(0);
-		}
+	string hashValueRemapped(string &P, uint nr_of_threads = 1){
 
 		assert(P.length()>=m);
 
+		bool quality = policy.quality();
+
 		ulint n = P.length();
 		ulint length=n-m+w;
-		lint blocks = m/w;
-
-		ulint bufsize=m+1;
-
-		lint r = m%w;
+		ulint blocks = m/w;
+		ulint r = m%w;
 
 		if(r==0){
 			blocks--;
 			r=w;
 		}
 
-		srand(time(NULL));
+		//there are 'blocks' blocks of length w and a final block of length r (which can be equal to w). Let D be the digits of P:
+		//digit i of h(P) is D[i] XOR D[i+w] XOR ... XOR D[i+(blocks-1)*w] XOR D[i+m-w] (if m=w, blocks=0: identity function; OR for quality types),
+		//where only the blocks selected by the policy appear (the final block has index 'blocks').
+		//The digits are computed in blocks of block_size: D is decoded in a linear buffer (no modular indexing), then the
+		//blocks+1 shifted windows of the buffer are XORed a machine word at a time. Blocks are independent, so they
+		//are distributed among nr_of_threads threads.
 
-		//there are 'blocks' blocks of length w and a final block of length r (which can be equal to w)
+		string res = string(length,0);
 
-		string res = string(length,'e');
+		const ulint block_size = 1<<16;
 
-		if(m==w){//identity function
+		parallel_for(length, block_size, nr_of_threads, [&](ulint b, ulint e){
 
-			for(ulint i=0;i<length;i++)
-				if(random_char[(uchar)P.at(i)])
-					res[i] = rand()%(base)+1;
-				else
-					res[i] = code[(uchar)P.at(i)]+1;
+			vector<uchar> D(block_size+m);
 
-			return res;
+			ulint len = e-b;
 
-		}
+			for(ulint k=0;k<len+m-w;k++)//digits D[b,...,e-1+m-w]
+				D[k] = digit(P,b+k);
 
-		vector<unsigned char> buffer(bufsize);
+			uchar * out = (uchar*)&res[b];
 
-		//fill buffer with the first m+1 digits
-		for(ulint i=0;i<bufsize;i++){
-			if(random_char[(uchar)P.at(i)])
-				buffer[i] = rand()%(base);
+			if(policy.useBlock(blocks))
+				memcpy(out,D.data()+m-w,len);
 			else
-				buffer[i] = code[(uchar)P.at(i)];
-		}
-
-		//compute first w digits
-		for(ulint i=0;i<w;i++){
-
-			res[i]=0;
-			for(lint j=0;j<blocks;j++)
-				res[i] ^= buffer[(i+j*w)%bufsize];
-
-			res[i] ^= buffer[(i+(blocks-1)*w+r)%bufsize];
-
-		}
-
-		//compute the other digits
-		ulint newpos=0;
+				memset(out,0,len);
 
-		for(ulint i=w;i<length;i++){
+			for(ulint j=0;j<blocks;j++)
+				if(policy.useBlock(j)){
 
-			res[i] = 	res[i-w] ^
-						buffer[(i-w)%bufsize] ^
-						buffer[((lint)i+(blocks-2)*(lint)w+r)%bufsize] ^
-						buffer[(i+(blocks-1)*w)%bufsize] ^
-						buffer[(i+(blocks-1)*w + r)%bufsize];
+					if(quality)
+						orInto(out,D.data()+j*w,len);
+					else
+						xorInto(out,D.data()+j*w,len);
 
-			newpos=i+m-w+1;
-
-			if(newpos<n){
-
-				if(random_char[(uchar)P.at(newpos)])
-					buffer[newpos%bufsize] = rand()%(base);
-				else
-					buffer[newpos%bufsize] = code[(uchar)P.at(newpos)];
-
-			}
+				}
 
-		}
+			for(ulint k=0;k<len;k++)//re-map adding 1 to each digit
+				out[k]++;
 
-		for(ulint i=0;i<length;i++)//re-map adding 1 to each digit
-			res[i]++;
+		});
 
 		return res;
 
@@ -362,9 +248,9 @@ public:
 
 	uint digitAt(ulint W, uint i){//i-th digit from right
 
-		uint mask = (1<<log_base)-1;
+		uint mask = (1<<policy.logBase())-1;
 
-		return (W>>(log_base*i)) & mask;
+		return (W>>(policy.logBase()*i)) & mask;
 
 	}
 
@@ -388,6 +274,14 @@ public:
 		fwrite(&log_base, sizeof(uint), 1, fp);
 		fwrite(&type, sizeof(hash_type), 1, fp);
 
+		vector<uint> code(256);
+		vector<uchar> random_char(256);
+
+		for(uint c=0;c<256;c++){
+			code[c] = policy.code(c);
+			random_char[c] = policy.random(c);
+		}
+
 		fwrite(code.data(), sizeof(uint), 256, fp);
 		fwrite(random_char.data(), sizeof(uchar), 256, fp);
 
@@ -410,14 +304,16 @@ public:
 		numBytes = fread(&type, sizeof(hash_type), 1, fp);
 		assert(numBytes>0);
 
-		code = vector<uint>(256);
-		random_char = vector<uchar>(256);
+		vector<uint> code(256);
+		vector<uchar> random_char(256);
 
 		numBytes = fread(code.data(), sizeof(uint), 256, fp);
 		assert(numBytes>0);
 		numBytes = fread(random_char.data(), sizeof(uchar), 256, fp);
 		assert(numBytes>0);
 
+		policy.load(type,base,log_base,code,random_char);
+
 		buildZSet();
 
 		numBytes++;//avoids "variable not used" warning
@@ -428,44 +324,157 @@ public:
 
 	SetZIterator getSetZIterator(){return SetZIterator(this);}
 
- 	uint base,m,w,r,log_base;
+	uint maxErrors(){return radius;}//maximum number of errors covered by the Z set
+
+	hash_policy hashPolicy(){return policy;}
+
+	//seed of the digits assigned to random characters (e.g. N in DNA_SEARCH) by hashValueRemapped
+	void setSeed(ulint seed){this->seed = seed;}
+
+ 	uint base,m,w,r,log_base;//base and log_base copy the policy; the hashing loops read the policy (constants for static policies)
 
 	hash_type type;
 
 
 protected:
 
+	//digit of the character in position i of P. Random characters get a pseudo-random digit that depends only on seed and i
+	inline uchar digit(string &P, ulint i){
+
+		uchar c = P[i];
+
+		if(policy.random(c))
+			return splitmix64(seed+i)%policy.base();
+
+		return policy.code(c);
+
+	}
+
+	static inline ulint splitmix64(ulint x){
+
+		x += 0x9E3779B97F4A7C15ULL;
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+
+		return x ^ (x >> 31);
+
+	}
+
+	//dst[k] ^= src[k] for k<len, 8 bytes at a time
+	static inline void xorInto(uchar * dst, const uchar * src, ulint len){
+
+		ulint k=0;
+
+		for(;k+8<=len;k+=8){
+
+			uint64_t a,b;
+
+			memcpy(&a,dst+k,8);
+			memcpy(&b,src+k,8);
+
+			a ^= b;
+
+			memcpy(dst+k,&a,8);
+
+		}
+
+		for(;k<len;k++)
+			dst[k] ^= src[k];
+
+	}
+
+	//dst[k] |= src[k] for k<len, 8 bytes at a time
+	static inline void orInto(uchar * dst, const uchar * src, ulint len){
+
+		ulint k=0;
+
+		for(;k+8<=len;k+=8){
+
+			uint64_t a,b;
+
+			memcpy(&a,dst+k,8);
+			memcpy(&b,src+k,8);
+
+			a |= b;
+
+			memcpy(dst+k,&a,8);
+
+		}
+
+		for(;k<len;k++)
+			dst[k] |= src[k];
+
+	}
+
 	ulint qualityHashValue(string &P){//compute quality fingerprint of pattern P of length m.
 
 		assert(P.size()==m);
 
-		ulint W = 0;
 		ulint result = 0;
 
-		for(uint i=0;i<m-r;i++){
+		for(uint j=0;j<(m-r)/w;j++)
+			if(policy.useBlock(j))
+				result = result|blockValue(P,j*w);
 
-			if(i%w==0){
-				result = result|W;
-				W = 0;
-			}
+		if(r>0 and policy.useBlock((m-r)/w))
+			result = result|blockValue(P,m-w);
 
-			W = (W<<log_base) + code[(uchar)P.at(i)];
+		return result;
 
-		}
+	}
+
+	//value of the w digits P[i,...,i+w-1] (most significant digit first)
+	inline ulint blockValue(string &P, ulint i){
+
+		ulint W = 0;
+
+		for(ulint k=i;k<i+w;k++)
+			W = (W<<policy.logBase()) + policy.code((uchar)P.at(k));
+
+		return W;
+
+	}
+
+	//w = log_b(mn) and Z set. sigma is only printed
+	void init(ulint n, ulint m, uint sigma, bool verbose){
 
-		result = result|W;
-		W = 0;
+		this->m = m;
+		this->type = policy.type();
+		this->base = policy.base();
+		this->log_base = policy.logBase();
 
-		if(r>0){
+		w = ceil(log2(m*n)/log_base);//optimal word size
+
+		//w must not exceed m!
+		if(w>m) w=m;
+
+		r = m%w;
 
-			for(uint i=m-w;i<m;i++)
-				W = (W<<log_base) + code[(uchar)P.at(i)];
+		bool used = r>0 and policy.useBlock((m-r)/w);
 
-			result = result|W;
+		for(uint j=0;j<(m-r)/w;j++)
+			used = used or policy.useBlock(j);
 
+		if(not used){
+			cout << "Error: the hash policy does not select any block of the pattern (w = " << w << ")." << endl;
+			exit(1);
 		}
 
-		return result;
+		if(verbose) cout << " File length : n = " << n<<endl;
+
+		if(verbose)	cout << " Pattern length : m = " << m<<endl;
+
+		if(verbose)	cout << " Alphabet size : sigma = " << sigma<<endl;
+
+		if(verbose)	cout << " Fingerprints base : b = " << base << " (" << log_base << " bits per digit)" << endl;
+
+		if(verbose)	cout << " Optimal word length : w = " << w<<endl << " Building Z set ... ";
+
+		buildZSet();
+
+		if(verbose)	cout << "Done." <<endl;
+
+		if(verbose)	cout << "Done." <<endl;
 
 	}
 
@@ -717,104 +726,19 @@ protected:
 	}
 
 
-	// ---------- init the type of hash function
-
-	void init_DEFAULT(){
-
-		//fingerprints are base 4. A character c is assigned the digit c%4.
-
-		base = 4;
-
-		for(uint i=0;i<256;i++){
-			code[i]=i%base;
-			random_char[i] = false;
-		}
-
-	}
-
-	void init_DNA_SEARCH(){
-
-		for(uint i=0;i<256;i++)
-			random_char[i] = true;
-
-		random_char[(uchar) 'a'] = random_char[(uchar) 'A'] = false;
-		random_char[(uchar) 'c'] = random_char[(uchar) 'C'] = false;
-		random_char[(uchar) 'g'] = random_char[(uchar) 'G'] = false;
-		random_char[(uchar) 't'] = random_char[(uchar) 'T'] = false;
-
-		base = 4;
-
-		code[(uchar) 'a'] = code[(uchar) 'A'] = 0;
-		code[(uchar) 'c'] = code[(uchar) 'C'] = 1;
-		code[(uchar) 'g'] = code[(uchar) 'G'] = 2;
-		code[(uchar) 't'] = code[(uchar) 'T'] = 3;
-		code[(uchar) 'n'] = code[(uchar) 'N'] = 0;
-		code[(uchar) '$'] = 1;
-
-	}
-
-	void init_BS_SEARCH(){
-
-		for(uint i=0;i<256;i++)
-			random_char[i] = true;
-
-		random_char[(uchar) 'a'] = random_char[(uchar) 'A'] = false;
-		random_char[(uchar) 'c'] = random_char[(uchar) 'C'] = false;
-		random_char[(uchar) 'g'] = random_char[(uchar) 'G'] = false;
-		random_char[(uchar) 't'] = random_char[(uchar) 'T'] = false;
-
-		base=2;
-
-		code[(uchar) 'a'] = code[(uchar) 'A'] = 0;
-		code[(uchar) 'c'] = code[(uchar) 'C'] = 1;
-		code[(uchar) 'g'] = code[(uchar) 'G'] = 0;
-		code[(uchar) 't'] = code[(uchar) 'T'] = 1;
-		code[(uchar) 'n'] = code[(uchar) 'N'] = 0;
-		code[(uchar) '$'] = 1;
-
-	}
-
-	void init_QUALITY_DNA_SEARCH(uint q){
-
-		for(uint i=0;i<256;i++)
-			random_char[i] = false;
-
-		for(uint i=0;i<256;i++)
-			code[i]=0;
-
-		base=4;
-
-		for(uint i=33;i<255;i++)
-			if(i-33<q)
-				code[i]=3;
-
-	}
-
-	void init_QUALITY_BS_SEARCH(uint q){
-
-		for(uint i=0;i<256;i++)
-			random_char[i] = false;
-
-		for(uint i=0;i<256;i++)
-			code[i]=0;
-
-		base = 2;
-
-		for(uint i=33;i<255;i++)
-			if(i-33<q)
-				code[i]=1;
-
-	}
-
 	const static uint radius = 2;//by default, Z set is built with at maximum radius 3 (in practice, at most 2 errors are introduced in the seeds)
 
-	vector<uint> code;//digit associated with each char in the text. Needed to compute the numeric hash value
-	vector<uchar> random_char;//assign a random digit to this char?
+	ulint seed = 0;//seed of the random digits
+
+	hash_policy policy;//digits of the characters and blocks of the pattern used in the fingerprint
 
 	vector<vector<ulint> > Z;//set Z
 	vector<uint> Z_size;//size of Z(i)
 
 };
+
+typedef HashFunction_t<runtime_hash_policy> HashFunction;
+
 }
 
 #endif /* HASHFUNCTION_H_ */
@@ -0,0 +1,344 @@
+/*
+ *  This file is part of BWTIL.
+ *  Copyright (c) by
+ *  Nicola Prezza <nicolapr@gmail.com>
+ *
+ *   BWTIL is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   BWTIL is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details (<http://www.gnu.org/licenses/>).
+ */
+
+//============================================================================
+// Name        : HashPolicies.h
+// Author      : Nicola Prezza
+// Version     : 1.0
+// Description : hash policies of the de Bruijn hash function (template argument of HashFunction_t and DBhash_t).
+//
+//	A policy decides the digit associated with each character and the blocks of the pattern that are XORed in the
+//	fingerprint. Interface:
+//
+//		uint base()						fingerprints base (a power of 2)
+//		uint logBase()					bits per digit
+//		hash_type type()				type stored in the index file
+//		bool quality()					true for quality hash functions (digits are ORed instead of XORed)
+//		uint code(uchar c)				digit of character c
+//		bool random(uchar c)			c gets a (seeded) pseudo-random digit in the text fingerprint
+//		bool useBlock(ulint j)			block j of the pattern (w characters starting at j*w; the last block is
+//										the suffix of length w) contributes to the fingerprint
+//		void load(type,base,log_base,code,random)	restore the policy from an index file
+//
+//	runtime_hash_policy selects the behavior at runtime through hash_type (this is the default HashFunction).
+//	The other policies are fixed at compile time: base, log_base and code tables are constexpr.
+//============================================================================
+
+#ifndef HASHPOLICIES_H_
+#define HASHPOLICIES_H_
+
+#include "../common/common.h"
+
+namespace bwtil {
+
+class runtime_hash_policy{
+
+public:
+
+	runtime_hash_policy(){};
+
+	//quality_threshold is meaningful only for QUALITY hash types
+	explicit runtime_hash_policy(hash_type type, uint quality_threshold=15){
+
+		this->type_ = type;
+
+		code_ = vector<uint>(256,0);
+		random_char = vector<uchar>(256,false);
+
+		if(type == DEFAULT)
+			init_DEFAULT();
+
+		if(type == DNA_SEARCH)
+			init_DNA_SEARCH();
+
+		if(type == BS_SEARCH)
+			init_BS_SEARCH();
+
+		if(type == QUALITY_DNA_SEARCH)
+			init_QUALITY_DNA_SEARCH(quality_threshold);
+
+		if(type == QUALITY_BS_SEARCH)
+			init_QUALITY_BS_SEARCH(quality_threshold);
+
+		log_base = ceil(log2(base_));
+
+	}
+
+	//DEFAULT hash function on the given alphabet: the i-th character in lexicographic order gets digit i mod base
+	explicit runtime_hash_policy(vector<uchar> alphabet){
+
+		this->type_ = DEFAULT;
+
+		code_ = vector<uint>(256,0);
+		random_char = vector<uchar>(256,false);
+
+		log_base = ceil(log2(alphabet.size()));
+
+		if(log_base>=8)
+			log_base=7;//max 7 bits per digit allowed, since value 255 is forbidden
+
+		base_ = ((ulint)1)<<log_base;
+
+		//sort alphabet
+
+		std::sort(alphabet.begin(),alphabet.end());
+
+		//calculate code
+
+		for(uint i=0;i<alphabet.size();i++)
+			code_[alphabet.at(i)] = i%base_;
+
+	}
+
+	uint base(){return base_;}
+	uint logBase(){return log_base;}
+	hash_type type(){return type_;}
+	bool quality(){return type_==QUALITY_DNA_SEARCH or type_==QUALITY_BS_SEARCH;}
+
+	inline uint code(uchar c){return code_[c];}
+	inline bool random(uchar c){return random_char[c];}
+	inline bool useBlock(ulint j){return true;}
+
+	void load(hash_type type, uint base, uint log_base, vector<uint> &code, vector<uchar> &random_char){
+
+		this->type_ = type;
+		this->base_ = base;
+		this->log_base = log_base;
+		this->code_ = code;
+		this->random_char = random_char;
+
+	}
+
+private:
+
+	// ---------- init the type of hash function
+
+	void init_DEFAULT(){
+
+		//fingerprints are base 4. A character c is assigned the digit c%4.
+
+		base_ = 4;
+
+		for(uint i=0;i<256;i++){
+			code_[i]=i%base_;
+			random_char[i] = false;
+		}
+
+	}
+
+	void init_DNA_SEARCH(){
+
+		for(uint i=0;i<256;i++)
+			random_char[i] = true;
+
+		random_char[(uchar) 'a'] = random_char[(uchar) 'A'] = false;
+		random_char[(uchar) 'c'] = random_char[(uchar) 'C'] = false;
+		random_char[(uchar) 'g'] = random_char[(uchar) 'G'] = false;
+		random_char[(uchar) 't'] = random_char[(uchar) 'T'] = false;
+
+		base_ = 4;
+
+		code_[(uchar) 'a'] = code_[(uchar) 'A'] = 0;
+		code_[(uchar) 'c'] = code_[(uchar) 'C'] = 1;
+		code_[(uchar) 'g'] = code_[(uchar) 'G'] = 2;
+		code_[(uchar) 't'] = code_[(uchar) 'T'] = 3;
+		code_[(uchar) 'n'] = code_[(uchar) 'N'] = 0;
+		code_[(uchar) '$'] = 1;
+
+	}
+
+	void init_BS_SEARCH(){
+
+		for(uint i=0;i<256;i++)
+			random_char[i] = true;
+
+		random_char[(uchar) 'a'] = random_char[(uchar) 'A'] = false;
+		random_char[(uchar) 'c'] = random_char[(uchar) 'C'] = false;
+		random_char[(uchar) 'g'] = random_char[(uchar) 'G'] = false;
+		random_char[(uchar) 't'] = random_char[(uchar) 'T'] = false;
+
+		base_=2;
+
+		code_[(uchar) 'a'] = code_[(uchar) 'A'] = 0;
+		code_[(uchar) 'c'] = code_[(uchar) 'C'] = 1;
+		code_[(uchar) 'g'] = code_[(uchar) 'G'] = 0;
+		code_[(uchar) 't'] = code_[(uchar) 'T'] = 1;
+		code_[(uchar) 'n'] = code_[(uchar) 'N'] = 0;
+		code_[(uchar) '$'] = 1;
+
+	}
+
+	void init_QUALITY_DNA_SEARCH(uint q){
+
+		for(uint i=0;i<256;i++)
+			random_char[i] = false;
+
+		for(uint i=0;i<256;i++)
+			code_[i]=0;
+
+		base_=4;
+
+		for(uint i=33;i<255;i++)
+			if(i-33<q)
+				code_[i]=3;
+
+	}
+
+	void init_QUALITY_BS_SEARCH(uint q){
+
+		for(uint i=0;i<256;i++)
+			random_char[i] = false;
+
+		for(uint i=0;i<256;i++)
+			code_[i]=0;
+
+		base_ = 2;
+
+		for(uint i=33;i<255;i++)
+			if(i-33<q)
+				code_[i]=1;
+
+	}
+
+	hash_type type_ = DEFAULT;
+	uint base_ = 4;
+	uint log_base = 2;
+
+	vector<uint> code_;//digit associated with each char in the text. Needed to compute the numeric hash value
+	vector<uchar> random_char;//assign a random digit to this char?
+
+};
+
+// ---------- compile-time policies
+
+template<ulint... I> struct index_sequence_t{};
+template<ulint N, ulint... I> struct make_index_sequence_t : make_index_sequence_t<N-1, N-1, I...>{};
+template<ulint... I> struct make_index_sequence_t<0, I...>{ typedef index_sequence_t<I...> type; };
+
+/*
+ * constexpr code tables of a policy: code[c] = policy::codeOf(c), random[c] = policy::isRandom(c)
+ */
+template<class policy, class seq = typename make_index_sequence_t<256>::type> struct code_tables;
+
+template<class policy, ulint... I> struct code_tables<policy, index_sequence_t<I...> >{
+
+	static constexpr uchar code[256] = { policy::codeOf(I)... };
+	static constexpr bool random[256] = { policy::isRandom(I)... };
+
+};
+
+template<class policy, ulint... I> constexpr uchar code_tables<policy, index_sequence_t<I...> >::code[256];
+template<class policy, ulint... I> constexpr bool code_tables<policy, index_sequence_t<I...> >::random[256];
+
+/*
+ * common part of the compile-time policies: loading from file only checks that the index was built with the same type
+ */
+template<hash_type T>
+class static_hash_policy{
+
+public:
+
+	static constexpr hash_type type(){return T;}
+	static constexpr bool quality(){return false;}
+
+	void load(hash_type type, uint base, uint log_base, vector<uint> &code, vector<uchar> &random_char){
+
+		if(type!=T){
+			cout << "Error: the index was built with a different hash function." << endl;
+			exit(1);
+		}
+
+	}
+
+};
+
+//same digits as DNA_SEARCH: A=0,C=1,G=2,T=3, any other character is random
+class dna_hash_policy : public static_hash_policy<DNA_SEARCH>{
+
+public:
+
+	static constexpr uint base(){return 4;}
+	static constexpr uint logBase(){return 2;}
+
+	static constexpr uint codeOf(ulint c){
+		return 	(c=='c' or c=='C') ? 1 :
+				(c=='g' or c=='G') ? 2 :
+				(c=='t' or c=='T') ? 3 : 0;
+	}
+
+	static constexpr bool isRandom(ulint c){
+		return not (c=='a' or c=='A' or c=='c' or c=='C' or c=='g' or c=='G' or c=='t' or c=='T');
+	}
+
+	static inline uint code(uchar c){return code_tables<dna_hash_policy>::code[c];}
+	static inline bool random(uchar c){return code_tables<dna_hash_policy>::random[c];}
+	static constexpr bool useBlock(ulint j){return true;}
+
+};
+
+//same digits as BS_SEARCH (bisulfite): C=T=1, A=G=0, any other character is random
+class bs_hash_policy : public static_hash_policy<BS_SEARCH>{
+
+public:
+
+	static constexpr uint base(){return 2;}
+	static constexpr uint logBase(){return 1;}
+
+	static constexpr uint codeOf(ulint c){
+		return 	(c=='c' or c=='C' or c=='t' or c=='T') ? 1 : 0;
+	}
+
+	static constexpr bool isRandom(ulint c){
+		return dna_hash_policy::isRandom(c);
+	}
+
+	static inline uint code(uchar c){return code_tables<bs_hash_policy>::code[c];}
+	static inline bool random(uchar c){return code_tables<bs_hash_policy>::random[c];}
+	static constexpr bool useBlock(ulint j){return true;}
+
+};
+
+/*
+ * spaced-seed DNA hash: as dna_hash_policy, but only the blocks j of the pattern with bit j of block_mask set contribute to the
+ * fingerprint (blocks j>=64 always contribute). Mismatches inside the other blocks ("don't care" blocks) do not change the
+ * fingerprint, so a pattern is found with any number of errors in those blocks. Positions are masked block by block (and not
+ * character by character) because digit i of the text fingerprint must be the same for all the windows covering it.
+ * At least one block must be used. The mask is not stored in the index file: load with the same policy used to build.
+ */
+template<ulint block_mask>
+class spaced_dna_hash_policy : public dna_hash_policy{
+
+public:
+
+	static_assert(block_mask!=0, "spaced seed with no blocks");
+
+	static constexpr hash_type type(){return SPACED_DNA_SEARCH;}
+
+	static constexpr bool useBlock(ulint j){return j>=64 or ((block_mask>>j)&1);}
+
+	void load(hash_type type, uint base, uint log_base, vector<uint> &code, vector<uchar> &random_char){
+
+		if(type!=SPACED_DNA_SEARCH){
+			cout << "Error: the index was built with a different hash function." << endl;
+			exit(1);
+		}
+
+	}
+
+};
+
+} /* namespace bwtil */
+#endif /* HASHPOLICIES_H_ */
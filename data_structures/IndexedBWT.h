@@ -34,6 +34,7 @@
 
 #include "WaveletTree.h"
 #include "succinct_bitvector.h"
+#include "SASampler.h"
 
 namespace bwtil {
 
@@ -44,154 +45,132 @@ public:
 
 	/*
 	 * constructor: takes as input BWT where terminator character is 0 and builds structures.
+	 * One SA pointer is stored every sample_rate text positions (if sample_rate=0, no SA pointers are stored)
 	 */
 	IndexedBWT(string &BWT, ulint sample_rate, bool verbose=false){
 
-		this->n=BWT.length();
-		this->offrate=sample_rate;
-
-		number_of_SA_pointers = (sample_rate==0?0:n/sample_rate + 1);
+		if(sample_rate==0){
 
-		if(verbose) cout << " Building indexed BWT data structure" << endl;
-		if(verbose) cout << "  Number of sampled SA pointers = " << number_of_SA_pointers << endl;
+			build(BWT,NULL,verbose);
 
-		w = ceil(log2(n));
-		if(w<1) w=1;
+		}else{
 
-		ulint nr_of_terminators=0;
+			TextSampler sampler(sample_rate);
+			build(BWT,&sampler,verbose);
 
-		//compute re-mapping to keep alphabet size to a minimum
-		//from text chars -> to integers in {0,...,sigma}. the 0x0 byte is also remapped in 0x0, as the first alphabet character.
-		remapping = vector<uchar>(256,0);
+			offrate = sample_rate;
 
-		//detect alphabet
-		vector<uchar> alphabet;
-		vector<bool> char_inserted = vector<bool>(256,false);
+		}
 
-		for(ulint i=0;i<n;i++){
+	}
 
-			if((uchar)BWT.at(i)==0){//found terminator. Save position
-				terminator_position = i;
-				nr_of_terminators++;
-			}else{
+	/*
+	 * constructor: takes as input BWT where terminator character is 0 and builds structures.
+	 * The sampler decides which BWT positions store a SA pointer (see SASampler.h)
+	 */
+	IndexedBWT(string &BWT, SASampler &sampler, bool verbose=false){
 
-				if(not char_inserted.at((uchar)BWT.at(i))){
+		build(BWT,&sampler,verbose);
 
-					alphabet.push_back((uchar)BWT.at(i));
-					char_inserted.at((uchar)BWT.at(i))=true;
+	}
 
-				}
+	ulint convertToTextCoordinate(ulint i){//i=address on BWT (F column). returns corresponding address on text
 
-			}
-		}
+		ulint l = 0;//number of LF steps
 
-		if(nr_of_terminators!=1){
+		while(marked_positions.at(i) == 0){
+			i = LF(i);
+			l++;
 
-			cout << "Error (IndexedBWT.cpp): the bwt contains no o more than one 0x0 bytes\n";
-			exit(1);
+			if(l>n){//prevents loop in case of errors in the BWT
+				cout << "Error: loop while scanning BWT. Check input BWT file.\n";
+				exit(1);
+			}
 
 		}
 
-		sigma = alphabet.size();
+		//here marked_positions.bitAt(i) == 1
 
-		//sort alphabet
+		return text_pointers[marked_positions.rank1(i)] + l;
 
-		std::sort(alphabet.begin(),alphabet.end());
+	}
 
-		//calculate remapping
-		//note: remapping of terminator (0x0) is 0
+	vector<ulint> convertToTextCoordinates(pair<ulint, ulint> interval){
 
-		for(uint i=0;i<alphabet.size();i++)
-			remapping[alphabet.at(i)] = i;
+		vector<ulint> coord;
+		for(uint i=interval.first;i<interval.second;i++)
+			coord.push_back( convertToTextCoordinate(i) );
 
-		//calculate inverse remapping
+		return coord;
 
-		inverse_remapping = vector<uchar>(sigma);
+	}
 
-		for(uint i=0;i<sigma;i++)
-			inverse_remapping[i] = alphabet.at(i);
+	/*
+	 * batched locate: same output as convertToTextCoordinates, but the LF walks of all the occurrences are advanced
+	 * in lock-step, one LF step per round. After each step the memory needed by the next step of that walk is prefetched,
+	 * so that the cache misses of different walks overlap. A walk is retired as soon as it reaches a sampled position.
+	 * Opt-in: the locate of succinctFMIndex and DBhash uses convertToTextCoordinates, since the batched locate is not
+	 * faster in the measurements of tools/locate-bench.
+	 */
+	vector<ulint> convertToTextCoordinatesBatch(pair<ulint, ulint> interval){
 
-		//apply remapping
+		ulint occ = interval.second>interval.first ? interval.second-interval.first : 0;
 
-		for(ulint i=0;i<n;i++)
-			BWT.at(i) = remapping[(uchar)BWT.at(i)];
+		vector<ulint> coord(occ);
 
-		bwt_wt =  WaveletTree(BWT,verbose);
+		vector<ulint> pos(occ);//current BWT position of each active walk
+		vector<ulint> id(occ);//index in coord of each active walk
 
-		marked_positions =  succinct_bitvector();
+		for(ulint k=0;k<occ;k++){
 
-		text_pointers =  packed_view_t(w,number_of_SA_pointers);
+			pos[k] = interval.first+k;
+			id[k] = k;
 
-		log_sigma = bwt_wt.bitsPerSymbol();
-
-		FIRST = vector<ulint>(256,0);
-
-		FIRST[TERMINATOR]=0;//first occurrence of terminator char in the first column is at the beginning
+		}
 
-		//count number of occurrences of each character
-		for(ulint i=0;i<n;i++)
-			if(i!=terminator_position)
-				FIRST[bwt_wt.charAt(i)]++;
+		ulint active = occ;
+		ulint l = 0;//number of LF steps performed by all active walks
 
-		for(uint i=1;i<255;i++)
-			FIRST[i] += FIRST[i-1];
+		while(active>0){
 
-		for(int i=254;i>0;i--)
-			FIRST[i] = FIRST[i-1];
+			ulint k=0;
 
-		FIRST[0] = 0;
+			while(k<active){
 
-		for(uint i=0;i<255;i++)
-			FIRST[i]++;
+				ulint i = pos[k];
 
-		//restore original values in BWT
-		for(ulint i=0;i<n;i++)
-			BWT.at(i) = inverse_remapping[(uchar)BWT.at(i)];
+				if(marked_positions.at(i)){
 
-		BWT.at(terminator_position) = 0;
+					//retire walk k: replace it with the last active walk
+					coord[id[k]] = text_pointers[marked_positions.rank1(i)] + l;
 
-		if(sample_rate>0){
-			if(verbose) cout << "\n  Marking positions containing a SA pointer ... ";
+					active--;
+					pos[k] = pos[active];
+					id[k] = id[active];
 
-			vector<bool> mark_pos = markPositions(verbose);
-			marked_positions = succinct_bitvector( mark_pos );
+				}else{
 
-			if(verbose) cout << "  Done.\n";
+					i = LF(i);
+					pos[k] = i;
 
-			if(verbose) cout << "\n  Sampling SA pointers ... ";
-			sampleSA(verbose);
-			if(verbose) cout << "  Done.\n";
-		}
+					marked_positions.prefetch(i);
+					bwt_wt.prefetch(i);
 
-	}
+					k++;
 
-	ulint convertToTextCoordinate(ulint i){//i=address on BWT (F column). returns corresponding address on text
+				}
 
-		ulint l = 0;//number of LF steps
+			}
 
-		while(marked_positions.at(i) == 0){
-			i = LF(i);
 			l++;
 
-			if(l>n){//prevents loop in case of errors in the BWT
+			if(l>n and active>0){//prevents loop in case of errors in the BWT
 				cout << "Error: loop while scanning BWT. Check input BWT file.\n";
 				exit(1);
 			}
 
 		}
 
-		//here marked_positions.bitAt(i) == 1
-
-		return text_pointers[marked_positions.rank1(i)] + l;
-
-	}
-
-	vector<ulint> convertToTextCoordinates(pair<ulint, ulint> interval){
-
-		vector<ulint> coord;
-		for(uint i=interval.first;i<interval.second;i++)
-			coord.push_back( convertToTextCoordinate(i) );
-
 		return coord;
 
 	}
@@ -207,8 +186,16 @@ public:
 
 	ulint LF(ulint i){//LF mapping from last column to first
 
-		uchar c = charAt_remapped(i);
-		return  FIRST[c] + rank(c,i);
+		if(i==terminator_position)
+			return FIRST[TERMINATOR] + rank(TERMINATOR,i);
+
+		//character and its rank with one descent of the wavelet tree
+		pair<uchar,ulint> cr = bwt_wt.access_rank(i);
+
+		if(cr.first==0 and i>terminator_position)//the terminator in the wavelet tree is encoded as 0 (see rank)
+			cr.second--;
+
+		return  FIRST[cr.first] + cr.second;
 
 	}
 
@@ -216,23 +203,41 @@ public:
 
 		ulint FIRST_size = (sigma+1)*64;
 
-		return bwt_wt.size() + marked_positions.size() + text_pointers.size()*text_pointers.width() + FIRST_size;
+		return bwt_wt.size() + sampledSASize() + FIRST_size;
+
+	}
+
+	ulint sampledSASize(){//returns size in bits of the sampled SA pointers (marked positions + text pointers)
+
+		return marked_positions.size() + text_pointers.size()*text_pointers.width();
 
 	}
 
+	ulint numberOfSamples(){return number_of_SA_pointers;}
+
 	/*
 	 *  To be used with the dB-hash data structure
-	 * 	search the suffix of length 'length' of the word W, where each character is formed by 'log_sigma' bits
+	 * 	search the suffix of length 'length' of the word W, where each character is formed by 'digit_width' bits
+	 * 	(default: log_sigma, which is correct only if all the digits occur in the BWT). Returns the empty interval <0,0>
+	 * 	if a digit does not appear in the BWT
 	 *
 	 */
-	pair<ulint, ulint> BS(ulint W, uint length,pair<ulint, ulint> interval= pair<ulint, ulint>(0,0)){
+	pair<ulint, ulint> BS(ulint W, uint length,pair<ulint, ulint> interval= pair<ulint, ulint>(0,0), uint digit_width = 0){
 
 		if(interval.first==0 and interval.second==0)//if default interval
 			interval.second = n;
 
+		if(digit_width==0)
+			digit_width = log_sigma;
+
 		for(uint i=0;i<length;i++){
 
-			auto c = remapping[digitAt(W,i)+1];//sum 1 since the BWT is built on the remapped text, where 1 is added to each digit
+			uchar d = ((W>>(digit_width*i)) & ((((ulint)1)<<digit_width)-1)) + 1;//sum 1 since the BWT is built on the remapped text, where 1 is added to each digit
+
+			if(inverse_remapping[remapping[d]]!=d)//d is not in the alphabet
+				return pair<ulint, ulint>(0,0);
+
+			auto c = remapping[d];
 
 			interval.first = FIRST[c] + rank(c,interval.first);
 			interval.second = FIRST[c] + rank(c,interval.second);
@@ -271,6 +276,25 @@ public:
 
 	}
 
+	/*
+	 * 	extend interval <lower_included, upper_excluded> on the BWT with (original, not remapped) character c.
+	 * 	returns the empty interval <0,0> if c does not appear in the BWT
+	 *
+	 */
+	pair<ulint, ulint> BS(pair<ulint, ulint> interval, uchar c){
+
+		if(c==0 or inverse_remapping[remapping[c]]!=c)//c is the terminator or it is not in the alphabet
+			return pair<ulint, ulint>(0,0);
+
+		c = remapping[c];//apply remapping
+
+		interval.first = FIRST[c] + rank(c,interval.first);
+		interval.second = FIRST[c] + rank(c,interval.second);
+
+		return interval;
+
+	}
+
 	~IndexedBWT() {}
 
 	void saveToFile(FILE *fp){
@@ -338,6 +362,120 @@ public:
 
 private:
 
+	/*
+	 * build the structures. If sampler==NULL, no SA pointers are stored.
+	 */
+	void build(string &BWT, SASampler * sampler, bool verbose){
+
+		this->n=BWT.length();
+
+		if(verbose) cout << " Building indexed BWT data structure" << endl;
+
+		w = ceil(log2(n));
+		if(w<1) w=1;
+
+		ulint nr_of_terminators=0;
+
+		//compute re-mapping to keep alphabet size to a minimum
+		//from text chars -> to integers in {0,...,sigma}. the 0x0 byte is also remapped in 0x0, as the first alphabet character.
+		remapping = vector<uchar>(256,0);
+
+		//detect alphabet and count number of occurrences of each character
+		vector<uchar> alphabet;
+		vector<ulint> char_count = vector<ulint>(256,0);
+
+		for(ulint i=0;i<n;i++){
+
+			if((uchar)BWT[i]==0){//found terminator. Save position
+				terminator_position = i;
+				nr_of_terminators++;
+			}else{
+
+				if(char_count[(uchar)BWT[i]]++ == 0)
+					alphabet.push_back((uchar)BWT[i]);
+
+			}
+		}
+
+		if(nr_of_terminators!=1){
+
+			cout << "Error (IndexedBWT.cpp): the bwt contains no o more than one 0x0 bytes\n";
+			exit(1);
+
+		}
+
+		sigma = alphabet.size();
+
+		//sort alphabet
+
+		std::sort(alphabet.begin(),alphabet.end());
+
+		//calculate remapping
+		//note: remapping of terminator (0x0) is 0
+
+		for(uint i=0;i<alphabet.size();i++)
+			remapping[alphabet.at(i)] = i;
+
+		//calculate inverse remapping
+
+		inverse_remapping = vector<uchar>(sigma);
+
+		for(uint i=0;i<sigma;i++)
+			inverse_remapping[i] = alphabet.at(i);
+
+		//apply remapping
+
+		for(ulint i=0;i<n;i++)
+			BWT.at(i) = remapping[(uchar)BWT.at(i)];
+
+		bwt_wt =  WaveletTree(BWT,verbose);
+
+		marked_positions =  succinct_bitvector();
+		text_pointers =  packed_view_t();
+		offrate = 0;
+
+		log_sigma = bwt_wt.bitsPerSymbol();
+
+		FIRST = vector<ulint>(256,0);
+
+		FIRST[TERMINATOR]=0;//first occurrence of terminator char in the first column is at the beginning
+
+		//number of occurrences of each (remapped) character
+		for(uint i=0;i<sigma;i++)
+			FIRST[i] = char_count[inverse_remapping[i]];
+
+		for(uint i=1;i<255;i++)
+			FIRST[i] += FIRST[i-1];
+
+		for(int i=254;i>0;i--)
+			FIRST[i] = FIRST[i-1];
+
+		FIRST[0] = 0;
+
+		for(uint i=0;i<255;i++)
+			FIRST[i]++;
+
+		//restore original values in BWT
+		for(ulint i=0;i<n;i++)
+			BWT.at(i) = inverse_remapping[(uchar)BWT.at(i)];
+
+		BWT.at(terminator_position) = 0;
+
+		number_of_SA_pointers = 0;
+
+		if(sampler!=NULL){
+
+			if(verbose) cout << "\n  Sampling SA pointers (" << sampler->name() << " sampling) ... ";
+			sampleSA(sampler,BWT,verbose);
+			if(verbose) cout << "  Done.\n";
+			if(verbose) cout << "  Number of sampled SA pointers = " << number_of_SA_pointers << endl;
+
+			offrate = n/number_of_SA_pointers;//average distance between two samples (overwritten by the sample_rate constructor)
+
+		}
+
+	}
+
 	//returns symbol stored in the wavelet tree at position i. The terminator is returned as 255
 	uchar charAt_remapped(ulint i){
 
@@ -364,18 +502,17 @@ private:
 
 	}
 
-	//returns i-th digit of log_sigma bits from right in the word W
-	uint digitAt(ulint W, uint i){
-
-		uint mask = (1<<log_sigma)-1;
-
-		return (W>>(log_sigma*i)) & mask;
-
-	}
+	/*
+	 * sample the SA pointers decided by the sampler with a single LF walk: the pairs <BWT position, text position>
+	 * are collected during the walk and then sorted by BWT position to fill marked_positions and text_pointers.
+	 * BWT is the input BWT (with original characters), used to detect the run heads.
+	 * Text position 0 is always sampled.
+	 */
+	void sampleSA(SASampler * sampler, string &BWT, bool verbose){
 
-	vector<bool> markPositions(bool verbose){//mark 1 every offrate positions of the text on the bwt (vector marked_positions)
+		vector<pair<ulint, ulint> > samples;//<BWT position, text position>
 
-		auto marked_pos_vec = vector<bool>(n,false);
+		sampler->init(n);
 
 		ulint i=n-1;//current position on text
 		ulint j=0;  //current position on the BWT (0=terminator position on the F column)
@@ -396,8 +533,8 @@ private:
 
 				}
 
-			if(i%offrate==0)
-				marked_pos_vec.at(j)=true;
+			if(sampler->sample(j,i,j==0 or BWT[j]!=BWT[j-1]))
+				samples.push_back(pair<ulint, ulint>(j,i));
 
 			j = LF(j);
 
@@ -406,45 +543,23 @@ private:
 		}
 
 		//i=0
-		marked_pos_vec.at(j)=true;
-		//marked_positions.setBit(j,1);
-		//marked_positions.computeRanks();
-
-		return marked_pos_vec;
+		samples.push_back(pair<ulint, ulint>(j,0));
 
-	}
-
-	void sampleSA(bool verbose){//sample Suffix Array pointers (1 every offrate positions on text). Vector marked_positions must be already computed!
-
-		ulint i=n-1;//current position on text
-		ulint j=0;  //current position on the BWT (0=terminator position on the F column)
-		uint perc;
-		uint last_perc=1;
+		std::sort(samples.begin(),samples.end());
 
-		if(verbose) cout << endl;
-
-		while(i>0){
-
-			perc = (100*(n-i))/n;
-
-			if(verbose)
-				if(perc%10==0 and perc!= last_perc){
-
-					cout << "   " << perc << "% done.\n";
-					last_perc=perc;
+		number_of_SA_pointers = samples.size();
+		text_pointers =  packed_view_t(w,number_of_SA_pointers);
 
-				}
+		vector<bool> mark_pos = vector<bool>(n,false);
 
-			if(marked_positions.at(j)==1)
-				text_pointers[marked_positions.rank1(j)] = i;
+		for(ulint k=0;k<number_of_SA_pointers;k++){
 
-			j = LF(j);
-			i--;
+			mark_pos[samples[k].first] = true;
+			text_pointers[k] = samples[k].second;
 
 		}
 
-		//i=0
-		text_pointers[marked_positions.rank1(j)] = 0;
+		marked_positions = succinct_bitvector( mark_pos );
 
 	}
 
@@ -457,7 +572,7 @@ private:
 
 	ulint n;//BWT length (included terminator character)
 	ulint terminator_position;//position of the terminator character in the BWT
-	ulint offrate;//distance on the text between 2 marked positions
+	ulint offrate;//(average) distance on the text between 2 marked positions
 
 	ulint number_of_SA_pointers;
 
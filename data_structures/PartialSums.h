@@ -94,6 +94,17 @@ public:
 		for(uint i=0;i<nr_of_nodes;i++)//reset all counters
 			nodes[i]=0;
 
+		//tree navigation tables (avoid divisions by d+1 in increment/getCount)
+		parent_of = vector<uint16_t>(nr_of_nodes,0);
+		child_nr = vector<uint8_t>(nr_of_nodes,0);
+
+		for(uint i=1;i<nr_of_nodes;i++){
+
+			parent_of[i] = parent(i);
+			child_nr[i] = childNumber(i);
+
+		}
+
 	}
 
 	string toString(){
@@ -114,7 +125,8 @@ public:
 
 	}
 
-	void increment(symbol s){
+	//insert k occurrences of symbol s: getCount(c) is incremented by k for all c>s
+	void increment(symbol s, ulint k=1){
 
 	#ifdef DEBUG
 		if(empty){
@@ -133,14 +145,47 @@ public:
 		uint current_node = (nr_of_nodes - nr_of_leafs) + (s/d);//offset leafs + leaf number
 		uint offset_in_node = s%d;//number of the counter inside the node
 
-		incrementFrom(&nodes, current_node, offset_in_node);//increment counters in the leaf
+		incrementFrom(&nodes, current_node, offset_in_node, k);//increment counters in the leaf
+
+		while(current_node>0){//repeat while current node is not the root
+
+			offset_in_node = child_nr[current_node];
+			current_node = parent_of[current_node];
+
+			incrementFrom(&nodes, current_node, offset_in_node, k);
+
+		}
+
+	}
+
+	//remove k occurrences of symbol s: getCount(c) is decremented by k for all c>s (at least k occurrences of s must be present)
+	void decrement(symbol s, ulint k=1){
+
+	#ifdef DEBUG
+		if(empty){
+			cout << "ERROR (PartialSums): decrement() called on empty counter\n";
+			exit(0);
+		}
+	#endif
+
+	#ifdef DEBUG
+		if(s>=sigma){
+			cout << "ERROR (PartialSums): symbol " << s << " not in alphabet.\n";
+			exit(0);
+		}
+	#endif
+
+		uint current_node = (nr_of_nodes - nr_of_leafs) + (s/d);//offset leafs + leaf number
+		uint offset_in_node = s%d;//number of the counter inside the node
+
+		decrementFrom(&nodes, current_node, offset_in_node, k);
 
 		while(current_node>0){//repeat while current node is not the root
 
-			offset_in_node = childNumber(current_node);
-			current_node = parent(current_node);
+			offset_in_node = child_nr[current_node];
+			current_node = parent_of[current_node];
 
-			incrementFrom(&nodes, current_node, offset_in_node);
+			decrementFrom(&nodes, current_node, offset_in_node, k);
 
 		}
 
@@ -176,8 +221,8 @@ public:
 
 		while(current_node>0){//repeat while current node is not the root
 
-			offset_in_node = childNumber(current_node);
-			current_node = parent(current_node);
+			offset_in_node = child_nr[current_node];
+			current_node = parent_of[current_node];
 
 			if(offset_in_node>0)
 				count += getCounterNumber(nodes[current_node],offset_in_node-1);
@@ -198,8 +243,8 @@ public:
 
 private:
 
-	//increment counters in node by 1 starting from counter number i (from left)
-	inline void incrementFrom(vector<ulint> * nodes, ulint node_nr, uint i){
+	//increment counters in node by k starting from counter number i (from left)
+	inline void incrementFrom(vector<ulint> * nodes, ulint node_nr, uint i, ulint k){
 
 	#ifdef DEBUG
 		if(empty){
@@ -221,7 +266,19 @@ private:
 
 		//printWord(MASK&ones);
 
-		nodes->at(node_nr) += (MASK&ones);
+		(*nodes)[node_nr] += (MASK&ones)*k;
+
+	}
+
+	//decrement counters in node by k starting from counter number i (from left). All these counters must be >= k,
+	//so that the subtraction does not borrow from the next counter
+	inline void decrementFrom(vector<ulint> * nodes, ulint node_nr, uint i, ulint k){
+
+		ulint MASK = ~((ulint)0);
+
+		if(i>0) MASK = ((ulint)1<<((d-i)*log2n))-1;
+
+		(*nodes)[node_nr] -= (MASK&ones)*k;
 
 	}
 
@@ -286,7 +343,7 @@ private:
 		}
 	#endif
 
-		return (n-(((n-1)%(d+1))+1))/(d+1);
+		return (n-1)/(d+1);
 
 	}
 
@@ -317,6 +374,9 @@ private:
 	ulint ones;//1^d in base 2^log2n
 	vector<ulint> nodes;//each node is a 64-bits word and stores d counters
 
+	vector<uint16_t> parent_of;//parent of each node
+	vector<uint8_t> child_nr;//child number of each node in its parent
+
 };
 
 
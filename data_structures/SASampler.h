@@ -0,0 +1,200 @@
+/*
+ *  This file is part of BWTIL.
+ *  Copyright (c) by
+ *  Nicola Prezza <nicolapr@gmail.com>
+ *
+ *   BWTIL is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   BWTIL is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details (<http://www.gnu.org/licenses/>).
+ */
+
+/*
+ * SASampler.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: nicola
+ *
+ *      Description: strategies deciding which BWT positions of an IndexedBWT store a SA pointer.
+ *      The IndexedBWT visits every (BWT position, text position) pair with one LF walk and asks the sampler
+ *      whether that pair has to be stored. Text position 0 is always sampled by the IndexedBWT (it stops the LF walks
+ *      before they cross the terminator), so samplers do not need to take care of it.
+ *
+ *      Note that only TextSampler bounds the number of LF steps of a locate (by its sample rate). The other samplers trade
+ *      this worst-case bound for a better space/time trade-off on particular texts or query distributions.
+ *
+ */
+
+#ifndef SASAMPLER_H_
+#define SASAMPLER_H_
+
+#include "../common/common.h"
+
+namespace bwtil {
+
+class SASampler{
+
+public:
+
+	SASampler(){};
+
+	virtual ~SASampler(){};
+
+	/*
+	 * called once before the LF walk. n = BWT length (terminator included)
+	 */
+	virtual void init(ulint n){};
+
+	/*
+	 * return true if the SA pointer of BWT position bwt_pos has to be stored. text_pos is the text position of the suffix
+	 * in position bwt_pos of the F column. run_head is true iff bwt_pos is the first position of an equal-letter run of the BWT
+	 */
+	virtual bool sample(ulint bwt_pos, ulint text_pos, bool run_head){return false;};
+
+	virtual string name(){return string("none");};
+
+};
+
+/*
+ * regular sampling on the text: one SA pointer every sample_rate text positions. Locate performs at most sample_rate-1 LF steps.
+ */
+class TextSampler : public SASampler{
+
+public:
+
+	TextSampler(ulint sample_rate){
+
+		assert(sample_rate>0);
+		this->sample_rate = sample_rate;
+
+	}
+
+	bool sample(ulint bwt_pos, ulint text_pos, bool run_head){return text_pos%sample_rate==0;};
+
+	string name(){return string("text");};
+
+private:
+
+	ulint sample_rate;
+
+};
+
+/*
+ * regular sampling on the BWT: one SA pointer every sample_rate BWT positions. Same space as TextSampler, but the number
+ * of LF steps of a locate is unbounded: the text positions of the sampled rows can be arbitrarily far apart, so there is
+ * no worst-case bound, and no average bound of sample_rate unless the text is random (see the bwt rows of tools/locate-bench).
+ */
+class BWTSampler : public SASampler{
+
+public:
+
+	BWTSampler(ulint sample_rate){
+
+		assert(sample_rate>0);
+		this->sample_rate = sample_rate;
+
+	}
+
+	bool sample(ulint bwt_pos, ulint text_pos, bool run_head){return bwt_pos%sample_rate==0;};
+
+	string name(){return string("bwt");};
+
+private:
+
+	ulint sample_rate;
+
+};
+
+/*
+ * sample the first position of each equal-letter BWT run, plus one text position every sample_rate (this bounds the
+ * number of LF steps of a locate). On repetitive texts the number of runs r is much smaller than n, so run heads are
+ * cheap to store; since LF maps BWT runs to contiguous ranges, many LF walks reach a run head early.
+ */
+class RunSampler : public SASampler{
+
+public:
+
+	RunSampler(ulint sample_rate){
+
+		assert(sample_rate>0);
+		this->sample_rate = sample_rate;
+
+	}
+
+	bool sample(ulint bwt_pos, ulint text_pos, bool run_head){return run_head or text_pos%sample_rate==0;};
+
+	string name(){return string("run");};
+
+private:
+
+	ulint sample_rate;
+
+};
+
+/*
+ * adaptive sampling driven by a query log. The text is divided in blocks of block_size positions; a block is hot if
+ * at least min_hits located text positions of the log fall inside it. Hot blocks are sampled every hot_sample_rate
+ * text positions, the others every sample_rate text positions.
+ * query_log = text positions returned by previous locate queries (e.g. collected on a production workload).
+ */
+class AdaptiveSampler : public SASampler{
+
+public:
+
+	AdaptiveSampler(ulint sample_rate, ulint hot_sample_rate, vector<ulint> &query_log, ulint block_size=1024, ulint min_hits=1){
+
+		assert(sample_rate>0 and hot_sample_rate>0 and block_size>0);
+
+		this->sample_rate = sample_rate;
+		this->hot_sample_rate = hot_sample_rate;
+		this->query_log = query_log;
+		this->block_size = block_size;
+		this->min_hits = min_hits;
+
+	}
+
+	void init(ulint n){
+
+		vector<ulint> hits(n/block_size+1,0);
+
+		for(auto p : query_log)
+			if(p<n)
+				hits[p/block_size]++;
+
+		hot = vector<bool>(hits.size(),false);
+
+		for(ulint i=0;i<hits.size();i++)
+			hot[i] = hits[i]>=min_hits;
+
+	}
+
+	bool sample(ulint bwt_pos, ulint text_pos, bool run_head){
+
+		if(hot[text_pos/block_size])
+			return text_pos%hot_sample_rate==0;
+
+		return text_pos%sample_rate==0;
+
+	}
+
+	string name(){return string("adaptive");};
+
+private:
+
+	ulint sample_rate;
+	ulint hot_sample_rate;
+	ulint block_size;
+	ulint min_hits;
+
+	vector<ulint> query_log;
+	vector<bool> hot;//hot blocks
+
+};
+
+} /* namespace bwtil */
+#endif /* SASAMPLER_H_ */
@@ -136,6 +136,46 @@ public:
 
 	}
 
+	/*
+	 * charAt and rank in a single root-to-leaf descent (inverse select): returns <c,rank(c,i)>, with c = charAt(i).
+	 * The rank of the bit read in each node is the position in the child, so at the leaf it is the rank of c.
+	 */
+	inline pair<uchar,ulint> access_rank(ulint i){
+
+		uchar c=0;
+		ulint node = root();
+
+		for(uint level=0;level<height();level++){
+
+			uint bit = nodes[node].at(i);
+			c = c*2 + bit;
+
+			if(bit==0){
+
+				i = nodes[node].rank0(i);
+				node = child0(node);
+
+			}else{
+
+				i = nodes[node].rank1(i);
+				node = child1(node);
+
+			}
+
+		}
+
+		return pair<uchar,ulint>(c,i);
+
+	}
+
+	//prefetch the root node around position i (the lower levels depend on the bits read in the root)
+	inline void prefetch(ulint i){
+
+		if(height()>0)
+			nodes[root()].prefetch(i);
+
+	}
+
 	ulint size(){//returns size of the structure in bits
 
 		ulint size = 0;
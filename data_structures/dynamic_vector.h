@@ -19,8 +19,8 @@
 // Author      : Nicola Prezza
 // Version     : 1.0
 /*
- * Description: a (semi) dynamic vector with access and insert-in-the-middle operations.
- * Substitute and delete are not yet implemented.
+ * Description: a dynamic vector with access, insert-in-the-middle, remove and set operations.
+ * remove and set require a dynamic bitvector with remove and set (e.g. packed_dynamic_bitvector).
  *
  */
 
@@ -111,6 +111,43 @@ public:
 
 	}
 
+	/*
+	 * remove the element in position i. Returns the removed element
+	 */
+	ulint remove(ulint i){
+
+		assert(i<current_length);
+
+		ulint value = 0;
+
+		for(uint j=0;j<width;j++)
+			value = 2*value + bv.remove(i*width);
+
+		current_length--;
+
+		return value;
+
+	}
+
+	/*
+	 * set the element in position i to w
+	 */
+	void set(ulint i, ulint w){
+
+		if(width<64)
+			assert(w<( ulint(1)<<width  ));
+
+		assert(i<current_length);
+
+		for(uint j=width;j>0;j--){
+
+			bv.set(i*width+j-1, w&ulint(1));
+			w = w >> 1;
+
+		}
+
+	}
+
 	/*
 	 * current vector length
 	 */
@@ -0,0 +1,374 @@
+/*
+ *  This file is part of BWTIL.
+ *  Copyright (c) by
+ *  Nicola Prezza <nicolapr@gmail.com>
+ *
+ *   BWTIL is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   BWTIL is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details (<http://www.gnu.org/licenses/>).
+ */
+
+//============================================================================
+// Name        : lz77_format.h
+// Author      : Nicola Prezza
+// Version     : 1.0
+// Description : binary format of an LZ77 parse (writer and decoder).
+//
+//	Format:
+//
+//		magic "BWTILZ77" (8 bytes), version (1 byte), text length n (varint)
+//		tokens, until n characters are covered. Each token is varint(length) followed by:
+//			length = 0 : one byte, a literal character
+//			length > 0 : varint(distance), distance = (phrase position) - (source position) >= 1
+//
+//	Varints are little-endian base-128 (7 bits per byte, high bit set on all bytes but the last).
+//	The source of a phrase may overlap the phrase itself (distance < length): the decoder copies
+//	the periodic string with memcpy in chunks of doubling size.
+//============================================================================
+
+#ifndef LZ77_FORMAT_H_
+#define LZ77_FORMAT_H_
+
+#include "../common/common.h"
+
+namespace bwtil {
+
+static const char lz77_magic[8] = {'B','W','T','I','L','Z','7','7'};
+static const uchar lz77_format_version = 1;
+
+/*
+ * writes a parse to file through a buffer. Phrases must be given in text order.
+ */
+class lz77_writer{
+
+public:
+
+	lz77_writer(){};
+
+	/*
+	 * \param fp: output file, opened in binary mode
+	 * \param n: length of the text
+	 */
+	lz77_writer(FILE * fp, ulint n, ulint buffer_size = (1<<20)){
+
+		this->fp = fp;
+		this->n = n;
+
+		buffer = vector<uchar>(buffer_size+20);
+		limit = buffer_size;
+
+		for(uint i=0;i<8;i++)
+			put(lz77_magic[i]);
+
+		put(lz77_format_version);
+		put_varint(n);
+
+	}
+
+	/*
+	 * text length not known in advance (e.g. single-pass parsing): the header stores a placeholder that
+	 * is overwritten by close(), so fp must be seekable.
+	 */
+	lz77_writer(FILE * fp){
+
+		this->fp = fp;
+		length_known = false;
+
+		buffer = vector<uchar>((1<<20)+20);
+		limit = (1<<20);
+
+		for(uint i=0;i<8;i++)
+			put(lz77_magic[i]);
+
+		put(lz77_format_version);
+		put_padded_varint(0);
+
+	}
+
+	//the next character of the text is c
+	void literal(uchar c){
+
+		put_varint(0);
+		put(c);
+
+		position++;
+		number_of_tokens++;
+
+		if(buffer_pos>=limit) flush();
+
+	}
+
+	//the next length characters of the text are a copy of text[source,...,source+length-1] (source < current position)
+	void phrase(ulint source, ulint length){
+
+		assert(length>0);
+		assert(source<position);
+
+		put_varint(length);
+		put_varint(position-source);
+
+		position+=length;
+		number_of_tokens++;
+
+		if(buffer_pos>=limit) flush();
+
+	}
+
+	/*
+	 * write a token of lz77_parser: tokens without a defined start position are single literal characters
+	 */
+	template<class token_type>
+	void write(const token_type &t){
+
+		if(t.start_position_is_defined)
+			phrase(t.start_position, t.phrase.size());
+		else
+			for(auto c : t.phrase)
+				literal(c);
+
+	}
+
+	//flush the buffer. Call once after the last token (checks that the whole text has been covered)
+	void close(){
+
+		if(not length_known){
+
+			flush();
+
+			//overwrite the placeholder with the text length
+			n = position;
+			put_padded_varint(n);
+
+			if(fseek(fp, 9, SEEK_SET)!=0 or fwrite(buffer.data(), 1, buffer_pos, fp)!=buffer_pos or fseek(fp, 0, SEEK_END)!=0){
+				cout << "Error while writing LZ77 parse: output file is not seekable." << endl;
+				exit(1);
+			}
+
+			buffer_pos = 0;
+			length_known = true;
+
+			return;
+
+		}
+
+		if(position!=n){
+			cout << "Error while writing LZ77 parse: the tokens cover " << position << " characters instead of " << n << endl;
+			exit(1);
+		}
+
+		flush();
+
+	}
+
+	ulint numberOfTokens(){return number_of_tokens;}
+	ulint bytes(){return bytes_written + buffer_pos;}
+
+private:
+
+	inline void put(uchar c){
+		buffer[buffer_pos++] = c;
+	}
+
+	inline void put_varint(ulint x){
+
+		while(x>=128){
+			put((x&127)|128);
+			x >>= 7;
+		}
+
+		put(x);
+
+	}
+
+	//varint of fixed length (10 bytes): the value can be overwritten in place
+	inline void put_padded_varint(ulint x){
+
+		for(uint i=0;i<9;i++){
+			put((x&127)|128);
+			x >>= 7;
+		}
+
+		put(x);
+
+	}
+
+	void flush(){
+
+		if(fwrite(buffer.data(), 1, buffer_pos, fp) != buffer_pos){
+			cout << "Error while writing LZ77 parse to file." << endl;
+			exit(1);
+		}
+
+		bytes_written += buffer_pos;
+		buffer_pos = 0;
+
+	}
+
+	FILE * fp = 0;
+
+	vector<uchar> buffer;
+	ulint buffer_pos = 0;
+	ulint limit = 0;//flush when buffer_pos reaches limit (a token takes at most 20 bytes)
+
+	ulint n = 0;//text length
+	bool length_known = true;
+	ulint position = 0;//characters covered so far
+	ulint number_of_tokens = 0;
+	ulint bytes_written = 0;
+
+};
+
+/*
+ * decodes a parse written with lz77_writer. The whole parse is loaded in memory.
+ */
+class lz77_decoder{
+
+public:
+
+	lz77_decoder(){};
+
+	lz77_decoder(FILE * fp){
+
+		//read whole file
+		uchar chunk[1<<16];
+		ulint r;
+		while((r = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+			parse.insert(parse.end(), chunk, chunk+r);
+
+		if(parse.size()<9 or memcmp(parse.data(), lz77_magic, 8)!=0){
+			cout << "Error: not a valid LZ77 parse file." << endl;
+			exit(1);
+		}
+
+		if(parse[8] != lz77_format_version){
+			cout << "Error: unsupported LZ77 parse version " << (uint)parse[8] << endl;
+			exit(1);
+		}
+
+		pos = 9;
+		n = get_varint();
+		tokens_begin = pos;
+
+	}
+
+	//length of the text
+	ulint size(){return n;}
+
+	ulint numberOfTokens(){return number_of_tokens;}
+
+	/*
+	 * decode the parse into out (at least size() bytes)
+	 */
+	void decode(uchar * out){
+
+		pos = tokens_begin;
+		number_of_tokens = 0;
+
+		ulint i = 0;//current text position
+
+		while(i<n){
+
+			ulint length = get_varint();
+
+			if(length==0){
+
+				check(pos<parse.size());
+				out[i++] = parse[pos++];
+
+			}else{
+
+				ulint distance = get_varint();
+
+				check(distance>0 and distance<=i and length<=n-i);
+
+				uchar * dst = out+i;
+				uchar * src = dst-distance;
+
+				if(distance>=length){
+
+					memcpy(dst, src, length);
+
+				}else{
+
+					//overlapping copy: out[i,...] is periodic with period distance. Copy out[src,...,dst-1]
+					//after the end of the copied prefix: the copied prefix doubles at each step.
+					ulint copied = 0;
+
+					while(copied<length){
+
+						ulint l = std::min(length-copied, distance+copied);
+						memcpy(dst+copied, src, l);
+						copied += l;
+
+					}
+
+				}
+
+				i += length;
+
+			}
+
+			number_of_tokens++;
+
+		}
+
+	}
+
+	string decode(){
+
+		string text(n,0);
+		decode((uchar*)&text[0]);
+		return text;
+
+	}
+
+private:
+
+	inline void check(bool ok){
+
+		if(not ok){
+			cout << "Error: corrupted LZ77 parse file." << endl;
+			exit(1);
+		}
+
+	}
+
+	inline ulint get_varint(){
+
+		ulint x = 0;
+		uint shift = 0;
+
+		check(pos<parse.size());
+
+		while(parse[pos]&128){
+
+			x |= ((ulint)(parse[pos++]&127))<<shift;
+			shift += 7;
+
+			check(pos<parse.size() and shift<64);
+
+		}
+
+		x |= ((ulint)parse[pos++])<<shift;
+
+		return x;
+
+	}
+
+	vector<uchar> parse;
+	ulint pos = 0;
+	ulint tokens_begin = 0;
+
+	ulint n = 0;
+	ulint number_of_tokens = 0;
+
+};
+
+} /* namespace bwtil */
+#endif /* LZ77_FORMAT_H_ */
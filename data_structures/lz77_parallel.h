@@ -0,0 +1,275 @@
+/*
+ *  This file is part of BWTIL.
+ *  Copyright (c) by
+ *  Nicola Prezza <nicolapr@gmail.com>
+ *
+ *   BWTIL is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   BWTIL is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details (<http://www.gnu.org/licenses/>).
+ */
+
+//============================================================================
+// Name        : lz77_parallel.h
+// Author      : Nicola Prezza
+// Version     : 1.0
+
+/*
+ * Block-parallel LZ77 parse of a file.
+ *
+ * The file is split in blocks of block_size characters, parsed in parallel by independent lz77_parser instances.
+ * The parser of block [b,e) is primed (lz77_parser::prime) with the window characters preceding the block,
+ * [max(0,b-window),b), so that the phrases of the block can copy from the window and from the block itself.
+ * A phrase never crosses the end of its block.
+ *
+ * Boundary reconciliation: blocks are then scanned in text order. The last phrase of a block is extended, with
+ * the same source, as long as the text matches after the end of the block (reading the file). The phrases of the
+ * following blocks that are covered by the extended phrase are removed, and a partially covered phrase is trimmed
+ * (a suffix of a copy is a copy with a shifted source).
+ *
+ * Deviation from the greedy parse: let z_w be the number of phrases of the greedy parse in which the source of the
+ * phrase starting at i lies in [i-window,i) (sliding window; window >= n gives the greedy parse). The phrases of
+ * block [b,e) can copy from [b-window,i) \supseteq [i-window,i), and greedy is optimal among the parses of [b,e)
+ * with these sources. Restricting the sliding-window greedy parse to [b,e) (trimming its phrase containing b and
+ * cutting its phrase containing e) gives a parse of the block with at most one more phrase than the number of
+ * its phrases starting in [b,e). Reconciliation never increases the number of phrases. Hence, with k blocks,
+ *
+ * 		number of phrases <= z_w + k - 1
+ *
+ * Each thread works on window + block_size characters: with window = block_size the total work is twice the
+ * sequential one, spread over the threads. The memory of each running thread is the dynamic BWT of
+ * window + block_size characters, plus the block and window text.
+ */
+//============================================================================
+
+#ifndef LZ77_PARALLEL_H_
+#define LZ77_PARALLEL_H_
+
+#include "../common/common.h"
+#include "lz77_parser.h"
+
+namespace bwtil {
+
+template <	typename bitvector_type = bitv,
+			class dynamic_vector_type = dynamic_vector_t
+		>
+class lz77_parallel {
+
+public:
+
+	/*
+	 * a phrase of the parse: text[start,...,start+length-1] = text[source,...,source+length-1] if source_is_defined,
+	 * otherwise the phrase is the single character literal.
+	 */
+	struct phrase_t{
+
+		ulint start;
+		ulint length;
+		ulint source;
+		bool source_is_defined;
+		uchar literal;
+
+	};
+
+	lz77_parallel(){};
+
+	/*
+	 * \param path: input file (must not contain 0x0 characters)
+	 * \param block_size: characters per block
+	 * \param window: characters preceding each block that its phrases can copy from
+	 * \param nr_of_threads
+	 * \param sample_rate: SA sample rate of the dynamic BWTs
+	 */
+	lz77_parallel(string path, ulint block_size, ulint window, uint nr_of_threads = 1, ulint sample_rate = 8, bool verbose = false){
+
+		assert(block_size>0);
+
+		this->path = path;
+
+		{
+			ifstream ifs(path, ios::binary | ios::ate);
+
+			if(not ifs.is_open()){
+				cout << "Error: cannot open file " << path << endl;
+				exit(1);
+			}
+
+			n = ifs.tellg();
+		}
+
+		ulint nr_of_blocks = (n+block_size-1)/block_size;
+		blocks = vector<vector<phrase_t> >(nr_of_blocks);
+
+		if(verbose)
+			cout << "Parsing " << nr_of_blocks << " blocks with " << nr_of_threads << " threads ..." << endl;
+
+		parallel_for(n, block_size, nr_of_threads, [&](ulint b, ulint e){
+
+			ulint w = std::min(b,window);
+
+			string segment = read(b-w, e-b+w);
+
+			set<pair<uchar,ulint> > aaf;
+
+			{
+				std::istringstream is(segment);
+				aaf = lz77_parser<bitvector_type,dynamic_vector_type>::get_alphabet_and_frequencies(is);
+			}
+
+			std::istringstream is(segment);
+			lz77_parser<bitvector_type,dynamic_vector_type> parser(is, aaf, sample_rate);
+
+			parser.prime(w);
+
+			vector<phrase_t> & phrases = blocks[b/block_size];
+
+			uchar last=0;
+
+			while(not parser.eof()){
+
+				auto t = parser.get_token_ref([&last](char c){ last = c; });
+
+				//positions in the segment -> positions in the text
+				phrases.push_back({t.start+b-w, t.length, t.source+b-w, t.source_is_defined, last});
+
+			}
+
+			if(verbose)
+				cout << "block [" << b << "," << e << ") parsed: " << phrases.size() << " phrases" << endl;
+
+		});
+
+		reconcile();
+
+	}
+
+	//total number of phrases
+	ulint numberOfPhrases(){return parse.size();}
+
+	//number of phrases before boundary reconciliation
+	ulint numberOfBlockPhrases(){return block_phrases;}
+
+	ulint size(){return n;}
+
+	//the phrases, in text order
+	vector<phrase_t> & phrases(){return parse;}
+
+private:
+
+	//read len characters of the file starting from position pos
+	string read(ulint pos, ulint len){
+
+		string s(len,0);
+
+		ifstream ifs(path, ios::binary);
+		ifs.seekg(pos);
+		ifs.read(&s[0], len);
+
+		if((ulint)ifs.gcount() != len){
+			cout << "Error while reading file " << path << endl;
+			exit(1);
+		}
+
+		return s;
+
+	}
+
+	/*
+	 * length of the longest common prefix of text[i,...,limit-1] and text[j,...] (j<i).
+	 * Reads the file in chunks.
+	 */
+	ulint lcp(ulint j, ulint i, ulint limit){
+
+		const ulint chunk = 1<<16;
+
+		ulint l = 0;
+
+		while(i+l<limit){
+
+			ulint len = std::min(chunk, limit-(i+l));
+
+			string a = read(j+l, len);
+			string b = read(i+l, len);
+
+			ulint k = 0;
+			while(k<len and a[k]==b[k]) k++;
+
+			l += k;
+
+			if(k<len) break;
+
+		}
+
+		return l;
+
+	}
+
+	void reconcile(){
+
+		block_phrases = 0;
+		for(auto &v : blocks)
+			block_phrases += v.size();
+
+		ulint covered = 0;//characters covered by the phrases in parse
+
+		for(auto &v : blocks){
+
+			for(ulint k=0;k<v.size();k++){
+
+				phrase_t p = v[k];
+
+				//phrase covered by the extension of a previous phrase
+				if(p.start+p.length<=covered)
+					continue;
+
+				//trim the prefix covered by a previous phrase
+				if(p.start<covered){
+
+					assert(p.source_is_defined);
+
+					ulint d = covered-p.start;
+
+					p.start += d;
+					p.source += d;
+					p.length -= d;
+
+				}
+
+				//last phrase of the block: extend it after the end of the block
+				if(k+1==v.size() and p.source_is_defined and p.start+p.length<n)
+					p.length += lcp(p.source+p.length, p.start+p.length, n);
+
+				covered = p.start+p.length;
+
+				parse.push_back(p);
+
+			}
+
+			vector<phrase_t>().swap(v);
+
+		}
+
+		assert(covered==n);
+
+	}
+
+	string path;
+	ulint n = 0;
+
+	vector<vector<phrase_t> > blocks;//phrases of each block, before reconciliation
+	vector<phrase_t> parse;
+
+	ulint block_phrases = 0;
+
+};
+
+typedef lz77_parallel<> lz77_parallel_t;
+
+} /* namespace bwtil */
+
+#endif /* LZ77_PARALLEL_H_ */
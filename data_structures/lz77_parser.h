@@ -59,6 +59,20 @@ public:
 
 	};
 
+	/*
+	 * token without the phrase: the phrase is text[start,...,start+length-1]. If source_is_defined, the phrase
+	 * is equal to text[source,...,source+length-1] with source < start (the two may overlap). Otherwise, the
+	 * phrase is the first occurrence of a character (length 1).
+	 */
+	struct token_ref{
+
+		ulint start;
+		ulint length;
+		ulint source;
+		bool source_is_defined;
+
+	};
+
 	/*
 	 * Compute online the lz77 parse of the input stream. Requires as input also the characters with
 	 * their absolute frequencies (in order to Huffman-compress the structures to H0).
@@ -111,12 +125,79 @@ public:
 
 	}
 
+	/*
+	 * Single-pass parser: alphabet, frequencies and length of the input are not needed, so the input can be a pipe
+	 * (e.g. cin). The input must not contain 0x0 characters: the parser exits with an error on the first one.
+	 *
+	 * The dynamic BWT starts with a balanced shape over all characters and capacity initial_capacity. Each character c
+	 * has a capacity: when c exceeds it, the BWT is re-encoded (DynamicBWT::reencode) with the Huffman shape of the
+	 * frequencies read so far and capacities 2*freq(c) + slack, slack = (characters read)/(2*sigma). A rebuild is
+	 * therefore triggered only by a character whose frequency more than doubled since the previous one, and the
+	 * capacity is at most 3 times the length of the input read so far.
+	 *
+	 * \param input: the input as an istream
+	 * \param sample_rate : Store SA pointers every sample_rate positions of the dynamic BWT
+	 * \param verbose
+	 * \param initial_capacity: initial capacity of the dynamic BWT (characters)
+	 *
+	 */
+	lz77_parser(std::istream & input, ulint sample_rate = 8, bool verbose = false, ulint initial_capacity = (1<<16)){
+
+		this->input = &input;
+		this->verbose = verbose;
+
+		single_pass = true;
+
+		//characters 1,...,255 are mapped to symbols 0,...,254. The terminator of the BWT is 255.
+		sigma = 255;
+
+		uchar_to_int = vector<uint>(256,sigma+1);
+		for(uint c=1;c<256;c++)
+			uchar_to_int[c] = c-1;
+
+		counts = vector<ulint>(sigma,0);
+		capacities = vector<ulint>(sigma, std::max(initial_capacity/sigma,(ulint)1));
+
+		dbwt = dynamic_bwt_type(capacities, sample_rate);
+
+		if(verbose)
+			cout << "Parsing input (LZ77, single pass) ..." << endl;
+
+	}
+
+	/*
+	 * returns the next phrase as a string (the phrase is copied). Use get_token_ref to avoid the copy.
+	 */
 	token get_token(){
 
+		string phrase;
+
+		token_ref t = get_token_ref([&phrase](char c){ phrase.push_back(c); });
+
+		return {phrase, t.source, t.source_is_defined};
+
+	}
+
+	/*
+	 * returns the next phrase without materializing it: (start, length, source position)
+	 */
+	token_ref get_token_ref(){
+
+		return get_token_ref([](char){});
+
+	}
+
+	/*
+	 * returns the next phrase without materializing it. sink(c) is called on each character c of the
+	 * phrase, in text order (e.g. to store or hash the phrase bytes).
+	 */
+	template<typename sink_type>
+	token_ref get_token_ref(sink_type sink){
+
 		assert(input!=0);
-		assert(position<=n);
+		assert(single_pass or position<=n);
 
-		if(verbose){
+		if(verbose and not single_pass){
 
 			int perc = ((position*100)/n);
 			if(perc>=last_perc+5){
@@ -128,66 +209,68 @@ public:
 
 		}
 
+		token_ref t = {position,0,0,false};
+
 		//if eof reached, return empty token
-		if(position==n)
-			return {string(),0,false};
+		if(end_of_input())
+			return t;
 
 		//current interval in the BWT. Start with full BWT
 		pair<ulint,ulint> interval = {0,dbwt.size()};
 
 		//position on the BWT of previous occurrence of a factor.
-		//if position_on_bwt == dbwt.getMaxLength(), position is
-		//not defined (first occurrence of a character)
 		ulint position_on_bwt = dbwt.getMaxLength();
 
 		//read character from the stream, extend the BWT interval
 		char c = read_char();
 		interval = dbwt.BS(interval,uchar_to_int[(uchar)c]);
 
-		//current phrase: at least 1 character
-		string phrase;
-
 		//if interval is empty here, we have the first occurrence of a character
 		if(interval.second <= interval.first){
 
 			//extend BWT with the character
-			dbwt.extend(uchar_to_int[(uchar)c]);
+			extend(uchar_to_int[(uchar)c]);
 
 			//we haven't already read following character
 			mismatching_character=0;
 
 			//phrase is only c
-			phrase = string()+c;
-			return {phrase,0,false};
+			sink(c);
+			t.length = 1;
 
-		}
+			return t;
 
-		//cout << c << " " << interval.first << " " << interval.second << endl;
+		}
 
 		position_on_bwt = interval.first;
 
-		if(position==n){
+		if(end_of_input()){
 
 			//phrase is only c
-			phrase = string()+c;
+			sink(c);
+			t.length = 1;
 
 			//character occurs before, so locate an occurrence
 			//dbwt.locate_right(position_on_bwt) returns position of the occurrence
 			//counting positions from the right. This is what we want since
 			//we are building the BWT of the reversed text. We subtract 1
 			//because there is a terminator character.
-			return {phrase, dbwt.locate_right(position_on_bwt)-1, true};
+			t.source = dbwt.locate_right(position_on_bwt)-1;
+			t.source_is_defined = true;
+
+			return t;
 
 		}
 
 		//extend BWT until possible
-		while(interval.second > interval.first and position < n){
+		while(interval.second > interval.first and not end_of_input()){
 
 			//append c to the current phrase
-			phrase = string(phrase)+c;
+			sink(c);
+			t.length++;
 
 			//extend BWT and obtain position where new suffix has been inserted
-			ulint o = dbwt.extend(uchar_to_int[(uchar)c]);
+			ulint o = extend(uchar_to_int[(uchar)c]);
 
 			//careful here! if we inserted the new suffix in position interval.first,
 			//we do not want to return position interval.first as occurrence of this
@@ -216,14 +299,15 @@ public:
 				mismatching_character = c;
 				position--;
 
-			}else if(position==n){
+			}else if(end_of_input()){
 
 				//I found the character, but stream is finished:
 				//extend phrase and bwt
 
-				phrase = string(phrase)+c;
+				sink(c);
+				t.length++;
 
-				ulint o = dbwt.extend(uchar_to_int[(uchar)c]);
+				ulint o = extend(uchar_to_int[(uchar)c]);
 
 				if(o==interval.first)
 					position_on_bwt = interval.first+1;
@@ -236,16 +320,52 @@ public:
 
 		}
 
-		return {phrase,dbwt.locate_right(position_on_bwt)-phrase.size(),true};
+		t.source = dbwt.locate_right(position_on_bwt)-t.length;
+		t.source_is_defined = true;
+
+		return t;
 
 	}
 
+
 	/*
-	 * returns total size of the stream
+	 * extend the dynamic BWT with the next m characters of the input without parsing them: these characters
+	 * become available as sources of the following phrases (whose positions still count them).
+	 * Call before the first get_token.
+	 */
+	void prime(ulint m){
+
+		assert(input!=0);
+		assert(single_pass or position+m<=n);
+
+		//extend in batches of 4096 characters
+		vector<symbol> batch;
+
+		for(ulint i=0;i<m and not end_of_input();i++){
+
+			batch.push_back(uchar_to_int[(uchar)read_char()]);
+
+			if(batch.size()==4096 or i+1==m or end_of_input()){
+
+				extend_batch(batch);
+				batch.clear();
+
+			}
+
+		}
+
+	}
+
+	/*
+	 * returns total size of the stream (single pass: number of characters parsed so far)
 	 */
 	ulint size(){
 
 		assert(input!=0);
+
+		if(single_pass)
+			return position;
+
 		return n;
 
 	}
@@ -256,12 +376,18 @@ public:
 	bool eof(){
 
 		assert(input!=0);
-		assert(position<=n);
+		assert(single_pass or position<=n);
 
-		return position >= n;
+		return end_of_input();
 
 	}
 
+	/*
+	 * single pass: number of times the dynamic BWT has been re-encoded, and its current capacity (characters)
+	 */
+	ulint numberOfRebuilds(){return rebuilds;}
+	ulint capacity(){return dbwt.getMaxLength()-1;}
+
 	/* Compute alphabet and frequencies of an input stream. To be used wile calling
 	 * the lz77_parser constructor.
 	 *
@@ -317,13 +443,88 @@ public:
 
 private:
 
+	//true if all characters of the input have been read
+	bool end_of_input(){
+
+		if(not single_pass)
+			return position >= n;
+
+		return mismatching_character==0 and input->peek()==EOF;
+
+	}
+
+	//extend the dynamic BWT with symbol s. Single pass: re-encode the BWT if s exceeds its capacity
+	ulint extend(symbol s){
+
+		if(single_pass){
+
+			if(counts[s]==capacities[s])
+				reencode();
+
+			counts[s]++;
+
+		}
+
+		return dbwt.extend(s);
+
+	}
+
+	void extend_batch(vector<symbol> &batch){
+
+		if(single_pass){
+
+			for(auto s : batch)
+				counts[s]++;
+
+			//re-encode if some symbol of the batch exceeds its capacity
+			for(uint s=0;s<sigma;s++)
+				if(counts[s]>capacities[s]){
+					reencode();
+					break;
+				}
+
+		}
+
+		dbwt.extend_batch(batch.data(), batch.size());
+
+	}
+
+	void reencode(){
+
+		ulint m = 0;//characters read so far
+		for(auto f : counts)
+			m += f;
+
+		ulint slack = std::max(m/(2*sigma),(ulint)1);
+
+		for(uint s=0;s<sigma;s++)
+			capacities[s] = 2*counts[s] + slack;
+
+		dbwt.reencode(capacities);
+		rebuilds++;
+
+		if(verbose)
+			cout << "Re-encoded the dynamic BWT after " << m << " characters. New capacity: " << capacity() << " characters." << endl;
+
+	}
+
 	char read_char(){
 
 		char c=mismatching_character;
 
-		if(c==0)
+		if(c==0){
+
 			input->read(&c,1);
-		else
+
+			//0x0 marks the absence of a mismatching character, and has no symbol in single-pass mode
+			if(single_pass and c==0 and input->gcount()==1){
+
+				cout << "Error: the input contains a 0x0 character (position " << position << "). The single-pass parser does not accept 0x0 characters." << endl;
+				exit(1);
+
+			}
+
+		}else
 			mismatching_character = 0;
 
 		position++;
@@ -353,6 +554,12 @@ private:
 
 	int last_perc=0;//for verbose output
 
+	//single-pass mode: the frequencies are not known in advance
+	bool single_pass=false;
+	vector<ulint> counts;//number of occurrences of each symbol read so far
+	vector<ulint> capacities;//frequencies used to build the dynamic BWT
+	ulint rebuilds=0;
+
 };
 
 } /* namespace data_structures */
@@ -0,0 +1,747 @@
+/*
+ *  This file is part of BWTIL.
+ *  Copyright (c) by
+ *  Nicola Prezza <nicolapr@gmail.com>
+ *
+ *   BWTIL is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   BWTIL is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details (<http://www.gnu.org/licenses/>).
+ */
+
+//============================================================================
+// Name        : packed_dynamic_bitvector.h
+// Author      : Nicola Prezza
+// Version     : 1.0
+/*
+ * Description: fully dynamic bitvector with access, rank, insert, remove and set operations.
+ * Same interface as the dynamic bitvector of extern/bitvector (it can be used as bitvector type of DynamicString,
+ * dynamic_vector and DynamicBWT), plus remove and set.
+ *
+ * The bitvector is a B-tree whose leaves store up to leaf_bits bits in 64-bit words. Internal nodes store the number
+ * of bits and of 1s in each subtree. All operations cost one root-to-leaf descent, O(log_fanout n) nodes, plus
+ * O(leaf_bits/64) word operations in the leaf.
+ *
+ * Rebalancing: a full leaf (internal node) is split in two halves. After a remove, a leaf (internal node) with less
+ * than 1/4 of the maximum size is merged with a sibling or, if the two do not fit in one node, their content is
+ * split evenly between them. A restructured node has at least 1/2 and at most 3/4 of the maximum size, so
+ * restructuring costs O(1) amortized node operations per insert/remove. Freed nodes are reused.
+ */
+
+#ifndef PACKED_DYNAMIC_BITVECTOR_H_
+#define PACKED_DYNAMIC_BITVECTOR_H_
+
+#include "../common/common.h"
+
+namespace bwtil {
+
+class packed_dynamic_bitvector{
+
+public:
+
+	struct info_t {
+		size_t capacity;
+		size_t size;
+		size_t height;
+		size_t node_width;
+		size_t counter_width;
+		size_t pointer_width;
+		size_t degree;
+		size_t buffer;
+		size_t nodes;
+		size_t leaves;
+	};
+
+	packed_dynamic_bitvector(){
+
+		init();
+
+	}
+
+	//create a dynamic bitvector of max size n. node_size is an unused parameter (as in DummyDynamicBitvector)
+	packed_dynamic_bitvector(ulint n, size_t node_size=0){
+
+		max_size = n;
+		init();
+
+	}
+
+	bool access(ulint i){
+
+		assert(i<current_size);
+
+		uint32_t node = root;
+
+		for(uint h=height;h>0;h--){
+
+			inner_t & in = inners[node];
+
+			uint k = 0;
+			while(i >= in.sizes[k]){
+				i -= in.sizes[k];
+				k++;
+			}
+
+			node = in.child[k];
+
+		}
+
+		return (leaves[node].words[i/64] >> (i%64)) & ulint(1);
+
+	}
+
+	bool operator[](ulint i){
+
+		return access(i);
+
+	}
+
+	//number of bits equal to x in positions 0,...,i-1
+	ulint rank(ulint i, bool x=true){
+
+		assert(i<=current_size);
+
+		ulint ones = 0;
+		ulint j = i;
+
+		uint32_t node = root;
+
+		for(uint h=height;h>0;h--){
+
+			inner_t & in = inners[node];
+
+			uint k = 0;
+			while(k+1<in.child.size() and j >= in.sizes[k]){
+				j -= in.sizes[k];
+				ones += in.ones[k];
+				k++;
+			}
+
+			node = in.child[k];
+
+		}
+
+		ones += leaf_rank(leaves[node], j);
+
+		return x ? ones : i-ones;
+
+	}
+
+	//insert bit x in position i
+	void insert(ulint i, bool x){
+
+		assert(i<=current_size);
+
+		uint32_t new_node;
+
+		//the root has been split: new root with two children
+		if(insert(root, height, i, x, new_node)){
+
+			uint32_t r = new_inner();
+
+			inners[r].child = {root, new_node};
+			inners[r].sizes = {subtree_size(root, height), subtree_size(new_node, height)};
+			inners[r].ones = {subtree_ones(root, height), subtree_ones(new_node, height)};
+
+			root = r;
+			height++;
+
+		}
+
+		current_size++;
+
+	}
+
+	void push_back(bool x){
+
+		insert(current_size, x);
+
+	}
+
+	//remove the bit in position i. Returns the removed bit
+	bool remove(ulint i){
+
+		assert(i<current_size);
+
+		bool x = remove(root, height, i);
+
+		//the root has only one child: the child becomes the root
+		while(height>0 and inners[root].child.size()==1){
+
+			uint32_t old_root = root;
+
+			root = inners[root].child[0];
+			height--;
+
+			free_inner(old_root);
+
+		}
+
+		current_size--;
+
+		return x;
+
+	}
+
+	//set the bit in position i to x
+	void set(ulint i, bool x){
+
+		assert(i<current_size);
+
+		if(access(i)==x)
+			return;
+
+		uint32_t node = root;
+
+		for(uint h=height;h>0;h--){
+
+			inner_t & in = inners[node];
+
+			uint k = 0;
+			while(i >= in.sizes[k]){
+				i -= in.sizes[k];
+				k++;
+			}
+
+			if(x) in.ones[k]++;
+			else in.ones[k]--;
+
+			node = in.child[k];
+
+		}
+
+		if(x) leaves[node].words[i/64] |= ulint(1) << (i%64);
+		else leaves[node].words[i/64] &= ~(ulint(1) << (i%64));
+
+	}
+
+	ulint size(){return current_size;}
+
+	info_t info() const {
+
+		return {max_size, current_size, height, 64, 64, 32, fanout, 0, inners.size()-free_inners.size(), leaves.size()-free_leaves.size()};
+
+	}
+
+	//number of bits used by the structure (leaves, sizes, counters and pointers of the internal nodes)
+	ulint bitSize(){
+
+		ulint bits = CHAR_BIT*sizeof(packed_dynamic_bitvector);
+
+		bits += CHAR_BIT*leaves.capacity()*sizeof(leaf_t);
+
+		for(auto & in : inners)
+			bits += CHAR_BIT*((in.sizes.capacity()+in.ones.capacity())*sizeof(ulint) + in.child.capacity()*sizeof(uint32_t) + sizeof(inner_t));
+
+		return bits;
+
+	}
+
+private:
+
+	static const uint leaf_words = 32;
+	static const uint leaf_bits = 64*leaf_words;//max bits in a leaf
+	static const uint fanout = 32;//max children of an internal node
+
+	struct leaf_t{
+
+		ulint words[leaf_words];//bit i in position i%64 of words[i/64]. Bits after size are 0
+		uint size;
+
+	};
+
+	struct inner_t{
+
+		vector<uint32_t> child;
+		vector<ulint> sizes;//number of bits in each subtree
+		vector<ulint> ones;//number of 1s in each subtree
+
+	};
+
+	void init(){
+
+		leaves.clear();
+		inners.clear();
+		free_leaves.clear();
+		free_inners.clear();
+
+		root = new_leaf();
+		height = 0;
+		current_size = 0;
+
+	}
+
+	uint32_t new_leaf(){
+
+		uint32_t l;
+
+		if(free_leaves.size()>0){
+
+			l = free_leaves.back();
+			free_leaves.pop_back();
+
+		}else{
+
+			leaves.push_back(leaf_t());
+			l = leaves.size()-1;
+
+		}
+
+		memset(leaves[l].words, 0, sizeof(leaves[l].words));
+		leaves[l].size = 0;
+
+		return l;
+
+	}
+
+	uint32_t new_inner(){
+
+		if(free_inners.size()>0){
+
+			uint32_t in = free_inners.back();
+			free_inners.pop_back();
+
+			return in;
+
+		}
+
+		inners.push_back(inner_t());
+
+		return inners.size()-1;
+
+	}
+
+	void free_leaf(uint32_t l){free_leaves.push_back(l);}
+
+	void free_inner(uint32_t in){
+
+		inners[in] = inner_t();
+		free_inners.push_back(in);
+
+	}
+
+	ulint subtree_size(uint32_t node, uint h){
+
+		if(h==0)
+			return leaves[node].size;
+
+		ulint s = 0;
+		for(auto x : inners[node].sizes)
+			s += x;
+
+		return s;
+
+	}
+
+	ulint subtree_ones(uint32_t node, uint h){
+
+		if(h==0)
+			return leaf_rank(leaves[node], leaves[node].size);
+
+		ulint s = 0;
+		for(auto x : inners[node].ones)
+			s += x;
+
+		return s;
+
+	}
+
+	inline ulint leaf_rank(const leaf_t & l, ulint i){
+
+		ulint r = 0;
+
+		for(ulint j=0;j<i/64;j++)
+			r += popcnt(l.words[j]);
+
+		if(i%64)
+			r += popcnt(l.words[i/64] & ((ulint(1)<<(i%64))-1));
+
+		return r;
+
+	}
+
+	//bits l.words[pos,...,pos+63] (positions after l.size are 0)
+	inline ulint leaf_get_word(const leaf_t & l, ulint pos){
+
+		ulint w = l.words[pos/64] >> (pos%64);
+
+		if(pos%64 and pos/64+1<leaf_words)
+			w |= l.words[pos/64+1] << (64-pos%64);
+
+		return w;
+
+	}
+
+	//append the len<=64 lowest bits of w at the end of l
+	inline void leaf_append(leaf_t & l, ulint w, uint len){
+
+		assert(l.size+len<=leaf_bits);
+
+		if(len<64)
+			w &= (ulint(1)<<len)-1;
+
+		uint offset = l.size%64;
+
+		if(len>0)
+			l.words[l.size/64] |= w << offset;
+
+		if(offset>0 and offset+len>64)
+			l.words[l.size/64+1] |= w >> (64-offset);
+
+		l.size += len;
+
+	}
+
+	//append the bits src[from,...,from+len-1] at the end of dst
+	void leaf_append(leaf_t & dst, const leaf_t & src, ulint from, ulint len){
+
+		for(ulint j=0;j<len;j+=64)
+			leaf_append(dst, leaf_get_word(src, from+j), std::min(len-j,(ulint)64));
+
+	}
+
+	//keep only the first size bits of l
+	void leaf_truncate(leaf_t & l, ulint size){
+
+		for(ulint j=(size+63)/64;j<leaf_words;j++)
+			l.words[j] = 0;
+
+		if(size%64)
+			l.words[size/64] &= (ulint(1)<<(size%64))-1;
+
+		l.size = size;
+
+	}
+
+	void leaf_insert(leaf_t & l, ulint i, bool x){
+
+		assert(l.size<leaf_bits);
+		assert(i<=l.size);
+
+		ulint k = i/64;
+		uint o = i%64;
+
+		ulint carry = l.words[k]>>63;
+		ulint low_mask = (ulint(1)<<o)-1;
+
+		l.words[k] = (l.words[k] & low_mask) | (ulint(x)<<o) | ((l.words[k] & ~low_mask)<<1);
+
+		for(ulint j=k+1;j<=l.size/64;j++){
+
+			ulint c = l.words[j]>>63;
+			l.words[j] = (l.words[j]<<1) | carry;
+			carry = c;
+
+		}
+
+		l.size++;
+
+	}
+
+	bool leaf_remove(leaf_t & l, ulint i){
+
+		assert(i<l.size);
+
+		ulint k = i/64;
+		uint o = i%64;
+
+		bool x = (l.words[k]>>o) & ulint(1);
+
+		ulint low_mask = (ulint(1)<<o)-1;
+		ulint high = o==63 ? 0 : (l.words[k]>>(o+1))<<o;
+
+		l.words[k] = (l.words[k] & low_mask) | high;
+
+		for(ulint j=k+1;j<=(l.size-1)/64;j++){
+
+			l.words[j-1] |= (l.words[j]&ulint(1))<<63;
+			l.words[j] >>= 1;
+
+		}
+
+		l.size--;
+
+		return x;
+
+	}
+
+	/*
+	 * insert x in position i of the subtree rooted in node (at height h; h=0: leaf).
+	 * Returns true if node has been split: the new right sibling is stored in new_node.
+	 */
+	bool insert(uint32_t node, uint h, ulint i, bool x, uint32_t & new_node){
+
+		if(h==0)
+			return insert_in_leaf(node, i, x, new_node);
+
+		uint k = 0;
+
+		{
+			inner_t & in = inners[node];
+			while(k+1<in.child.size() and i > in.sizes[k]){
+				i -= in.sizes[k];
+				k++;
+			}
+		}
+
+		uint32_t child_node = inners[node].child[k];
+		uint32_t new_child;
+
+		bool split = insert(child_node, h-1, i, x, new_child);
+
+		//the recursive call may have reallocated the pools: take the reference again
+		inner_t & in = inners[node];
+
+		in.sizes[k]++;
+		in.ones[k] += x;
+
+		if(not split)
+			return false;
+
+		in.child.insert(in.child.begin()+k+1, new_child);
+		in.sizes[k] = subtree_size(child_node, h-1);
+		in.sizes.insert(in.sizes.begin()+k+1, subtree_size(new_child, h-1));
+		in.ones[k] = subtree_ones(child_node, h-1);
+		in.ones.insert(in.ones.begin()+k+1, subtree_ones(new_child, h-1));
+
+		if(in.child.size()<=fanout)
+			return false;
+
+		//split this node: move the right half of the children to a new node
+		uint32_t r = new_inner();
+
+		inner_t & left = inners[node];
+		inner_t & right = inners[r];
+		uint half = left.child.size()/2;
+
+		right.child = vector<uint32_t>(left.child.begin()+half, left.child.end());
+		right.sizes = vector<ulint>(left.sizes.begin()+half, left.sizes.end());
+		right.ones = vector<ulint>(left.ones.begin()+half, left.ones.end());
+
+		left.child.resize(half);
+		left.sizes.resize(half);
+		left.ones.resize(half);
+
+		new_node = r;
+
+		return true;
+
+	}
+
+	bool insert_in_leaf(uint32_t node, ulint i, bool x, uint32_t & new_node){
+
+		if(leaves[node].size<leaf_bits){
+
+			leaf_insert(leaves[node], i, x);
+			return false;
+
+		}
+
+		//leaf is full: split it in two halves (word aligned), then insert
+		uint32_t r = new_leaf();
+
+		leaf_t & l = leaves[node];
+		leaf_t & right = leaves[r];
+
+		const uint half = leaf_bits/2;
+
+		leaf_append(right, l, half, l.size-half);
+		leaf_truncate(l, half);
+
+		if(i<=half)
+			leaf_insert(l, i, x);
+		else
+			leaf_insert(right, i-half, x);
+
+		new_node = r;
+
+		return true;
+
+	}
+
+	bool underfull(uint32_t node, uint h){
+
+		if(h==0)
+			return leaves[node].size < leaf_bits/4;
+
+		return inners[node].child.size() < fanout/4;
+
+	}
+
+	/*
+	 * remove the bit in position i of the subtree rooted in node (at height h). Children of node that become
+	 * underfull are merged with a sibling or rebalanced.
+	 */
+	bool remove(uint32_t node, uint h, ulint i){
+
+		if(h==0)
+			return leaf_remove(leaves[node], i);
+
+		uint k = 0;
+
+		{
+			inner_t & in = inners[node];
+			while(i >= in.sizes[k]){
+				i -= in.sizes[k];
+				k++;
+			}
+		}
+
+		bool x = remove(inners[node].child[k], h-1, i);
+
+		inner_t & in = inners[node];
+
+		in.sizes[k]--;
+		in.ones[k] -= x;
+
+		if(in.child.size()>1 and underfull(in.child[k], h-1))
+			rebalance(node, h, k+1<in.child.size() ? k : k-1);
+
+		return x;
+
+	}
+
+	//merge or rebalance children k and k+1 of node (at height h)
+	void rebalance(uint32_t node, uint h, uint k){
+
+		uint32_t a = inners[node].child[k];
+		uint32_t b = inners[node].child[k+1];
+
+		if(h==1)
+			rebalance_leaves(a, b);
+		else
+			rebalance_inners(a, b);
+
+		inner_t & in = inners[node];
+
+		//b is empty if it has been merged into a
+		bool merged = h==1 ? leaves[b].size==0 : inners[b].child.size()==0;
+
+		if(merged){
+
+			if(h==1) free_leaf(b);
+			else free_inner(b);
+
+			in.child.erase(in.child.begin()+k+1);
+			in.sizes.erase(in.sizes.begin()+k+1);
+			in.ones.erase(in.ones.begin()+k+1);
+
+		}else{
+
+			in.sizes[k+1] = subtree_size(b, h-1);
+			in.ones[k+1] = subtree_ones(b, h-1);
+
+		}
+
+		in.sizes[k] = subtree_size(a, h-1);
+		in.ones[k] = subtree_ones(a, h-1);
+
+	}
+
+	//merge leaf b into leaf a if they fit in one leaf, otherwise split their bits evenly
+	void rebalance_leaves(uint32_t a, uint32_t b){
+
+		leaf_t & la = leaves[a];
+		leaf_t & lb = leaves[b];
+
+		ulint total = la.size + lb.size;
+
+		if(total <= leaf_bits){
+
+			leaf_append(la, lb, 0, lb.size);
+			leaf_truncate(lb, 0);
+
+			return;
+
+		}
+
+		ulint half = total/2;
+
+		if(la.size < half){
+
+			//move the first half-la.size bits of b to the end of a
+			ulint d = half-la.size;
+
+			leaf_append(la, lb, 0, d);
+
+			leaf_t rest;
+			memset(rest.words, 0, sizeof(rest.words));
+			rest.size = 0;
+
+			leaf_append(rest, lb, d, lb.size-d);
+			lb = rest;
+
+		}else{
+
+			//move the last la.size-half bits of a to the beginning of b
+			leaf_t moved;
+			memset(moved.words, 0, sizeof(moved.words));
+			moved.size = 0;
+
+			leaf_append(moved, la, half, la.size-half);
+			leaf_append(moved, lb, 0, lb.size);
+
+			lb = moved;
+			leaf_truncate(la, half);
+
+		}
+
+	}
+
+	//merge internal node b into a if they fit in one node, otherwise split their children evenly
+	void rebalance_inners(uint32_t a, uint32_t b){
+
+		inner_t & ia = inners[a];
+		inner_t & ib = inners[b];
+
+		ulint total = ia.child.size() + ib.child.size();
+		ulint half = total <= fanout ? total : total/2;
+
+		if(ia.child.size() < half){
+
+			ulint d = half-ia.child.size();
+
+			ia.child.insert(ia.child.end(), ib.child.begin(), ib.child.begin()+d);
+			ia.sizes.insert(ia.sizes.end(), ib.sizes.begin(), ib.sizes.begin()+d);
+			ia.ones.insert(ia.ones.end(), ib.ones.begin(), ib.ones.begin()+d);
+
+			ib.child.erase(ib.child.begin(), ib.child.begin()+d);
+			ib.sizes.erase(ib.sizes.begin(), ib.sizes.begin()+d);
+			ib.ones.erase(ib.ones.begin(), ib.ones.begin()+d);
+
+		}else{
+
+			ib.child.insert(ib.child.begin(), ia.child.begin()+half, ia.child.end());
+			ib.sizes.insert(ib.sizes.begin(), ia.sizes.begin()+half, ia.sizes.end());
+			ib.ones.insert(ib.ones.begin(), ia.ones.begin()+half, ia.ones.end());
+
+			ia.child.resize(half);
+			ia.sizes.resize(half);
+			ia.ones.resize(half);
+
+		}
+
+	}
+
+	ulint max_size = ulint(1)<<40;
+	ulint current_size = 0;
+
+	vector<leaf_t> leaves;
+	vector<inner_t> inners;
+
+	vector<uint32_t> free_leaves;//indexes of the freed nodes, reused by new_leaf/new_inner
+	vector<uint32_t> free_inners;
+
+	uint32_t root = 0;
+	uint height = 0;//0: the root is a leaf
+
+};
+
+}//namespace bwtil
+
+#endif /* PACKED_DYNAMIC_BITVECTOR_H_ */
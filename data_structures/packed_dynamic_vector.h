@@ -0,0 +1,641 @@
+/*
+ *  This file is part of BWTIL.
+ *  Copyright (c) by
+ *  Nicola Prezza <nicolapr@gmail.com>
+ *
+ *   BWTIL is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   BWTIL is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details (<http://www.gnu.org/licenses/>).
+ */
+
+//============================================================================
+// Name        : packed_dynamic_vector.h
+// Author      : Nicola Prezza
+// Version     : 1.0
+/*
+ * Description: dynamic vector of fixed-width integers with access, insert-in-the-middle, remove and set operations.
+ * Same interface as dynamic_vector (it can be used as dynamic_vector_type of DynamicBWT and lz77_parser).
+ *
+ * The vector is a B-tree whose leaves store up to leaf_bits/width integers packed in 64-bit words. Internal nodes store
+ * the number of integers in each subtree. Access and insert cost one root-to-leaf descent, O(log_fanout n) nodes,
+ * plus O(leaf size) field moves in the leaf for insert and remove (dynamic_vector performs width insertions of single
+ * bits in a dynamic bitvector).
+ *
+ * After a remove, a node with less than 1/4 of the maximum size is merged with a sibling or, if the two do not fit
+ * in one node, their content is split evenly between them (as in packed_dynamic_bitvector).
+ *
+ * Nodes are stored in two pools (leaves and internal nodes) and addressed by index, so the structure can be copied.
+ * Freed nodes are reused.
+ */
+
+#ifndef PACKED_DYNAMIC_VECTOR_H_
+#define PACKED_DYNAMIC_VECTOR_H_
+
+#include "../common/common.h"
+
+namespace bwtil {
+
+class packed_dynamic_vector{
+
+public:
+
+	/*
+	 * default constructor. Sets a large max length (2^40) and width=64 bits
+	 */
+	packed_dynamic_vector(){
+
+		max_length = ulint(1)<<40;
+		init();
+
+	}
+
+	/*
+	 * constructor with max length of the vector and integer width
+	 */
+	packed_dynamic_vector(ulint max_length, uint width){
+
+		assert(width>0 and width<=64);
+
+		this->width = width;
+		this->max_length = max_length;
+
+		init();
+
+	}
+
+	/*
+	 * get element in position i
+	 */
+	ulint const operator[](ulint i){
+
+		return get(i);
+
+	}
+
+	/*
+	 * get element in position i
+	 */
+	ulint get(ulint i){
+
+		assert(i<current_length);
+
+		uint32_t node = root;
+
+		for(uint h=height;h>0;h--){
+
+			inner_t & in = inners[node];
+
+			uint k = 0;
+			while(i >= in.sizes[k]){
+				i -= in.sizes[k];
+				k++;
+			}
+
+			node = in.child[k];
+
+		}
+
+		return get_field(leaves[node].words, i);
+
+	}
+
+	/*
+	 * insert integer w in position i
+	 */
+	void insert(ulint i, ulint w){
+
+		if(width<64)
+			assert(w<( ulint(1)<<width  ));
+
+		assert(current_length<max_length);
+		assert(i<=current_length);
+
+		uint32_t new_node;
+
+		//the root has been split: new root with two children
+		if(insert(root, height, i, w, new_node)){
+
+			inner_t r;
+
+			r.child.push_back(root);
+			r.child.push_back(new_node);
+
+			r.sizes.push_back(subtree_size(root, height));
+			r.sizes.push_back(subtree_size(new_node, height));
+
+			inners.push_back(r);
+
+			root = inners.size()-1;
+			height++;
+
+		}
+
+		current_length++;
+
+	}
+
+	/*
+	 * remove the element in position i. Returns the removed element
+	 */
+	ulint remove(ulint i){
+
+		assert(i<current_length);
+
+		ulint w = remove(root, height, i);
+
+		//the root has only one child: the child becomes the root
+		while(height>0 and inners[root].child.size()==1){
+
+			uint32_t old_root = root;
+
+			root = inners[root].child[0];
+			height--;
+
+			free_inner(old_root);
+
+		}
+
+		current_length--;
+
+		return w;
+
+	}
+
+	/*
+	 * set the element in position i to w
+	 */
+	void set(ulint i, ulint w){
+
+		if(width<64)
+			assert(w<( ulint(1)<<width  ));
+
+		assert(i<current_length);
+
+		uint32_t node = root;
+
+		for(uint h=height;h>0;h--){
+
+			inner_t & in = inners[node];
+
+			uint k = 0;
+			while(i >= in.sizes[k]){
+				i -= in.sizes[k];
+				k++;
+			}
+
+			node = in.child[k];
+
+		}
+
+		set_field(leaves[node].words, i, w);
+
+	}
+
+	/*
+	 * current vector length
+	 */
+	ulint length(){return current_length;}
+	ulint size(){return current_length;}
+
+	/*
+	 * maximum number of elements that can be stored in the vector
+	 */
+	ulint capacity(){return max_length;}
+
+	/*
+	 * number of bits used by the structure (allocated words of the leaves, sizes and pointers of the internal nodes)
+	 */
+	ulint bitSize(){
+
+		ulint bits = CHAR_BIT*sizeof(packed_dynamic_vector);
+
+		for(auto & l : leaves)
+			bits += 64*l.words.capacity() + CHAR_BIT*sizeof(leaf_t);
+
+		for(auto & in : inners)
+			bits += CHAR_BIT*(in.sizes.capacity()*sizeof(ulint) + in.child.capacity()*sizeof(uint32_t) + sizeof(inner_t));
+
+		return bits;
+
+	}
+
+private:
+
+	static const uint leaf_bits = 2048;//bits of the integers stored in a leaf
+	static const uint fanout = 32;//max children of an internal node
+
+	struct leaf_t{
+
+		vector<ulint> words;
+		uint size;
+
+	};
+
+	struct inner_t{
+
+		vector<uint32_t> child;
+		vector<ulint> sizes;//number of integers in each subtree
+
+	};
+
+	void init(){
+
+		leaf_capacity = std::max(leaf_bits/width,(uint)2);
+
+		leaves.clear();
+		inners.clear();
+		free_leaves.clear();
+		free_inners.clear();
+
+		root = new_leaf();
+		height = 0;
+
+	}
+
+	uint32_t new_leaf(){
+
+		uint32_t l;
+
+		if(free_leaves.size()>0){
+
+			l = free_leaves.back();
+			free_leaves.pop_back();
+
+		}else{
+
+			leaves.push_back(leaf_t());
+			l = leaves.size()-1;
+
+		}
+
+		leaves[l].words = vector<ulint>((leaf_capacity*width+63)/64,0);
+		leaves[l].size = 0;
+
+		return l;
+
+	}
+
+	uint32_t new_inner(){
+
+		if(free_inners.size()>0){
+
+			uint32_t in = free_inners.back();
+			free_inners.pop_back();
+
+			return in;
+
+		}
+
+		inners.push_back(inner_t());
+
+		return inners.size()-1;
+
+	}
+
+	void free_leaf(uint32_t l){
+
+		leaves[l] = leaf_t();
+		free_leaves.push_back(l);
+
+	}
+
+	void free_inner(uint32_t in){
+
+		inners[in] = inner_t();
+		free_inners.push_back(in);
+
+	}
+
+	inline ulint get_field(const vector<ulint> & words, ulint i){
+
+		ulint b = i*width;
+		ulint word = b/64;
+		uint offset = b%64;
+
+		ulint value = words[word] >> offset;
+
+		if(offset+width>64)
+			value |= words[word+1] << (64-offset);
+
+		return width==64 ? value : value & ((ulint(1)<<width)-1);
+
+	}
+
+	inline void set_field(vector<ulint> & words, ulint i, ulint x){
+
+		ulint b = i*width;
+		ulint word = b/64;
+		uint offset = b%64;
+
+		ulint mask = width==64 ? ~ulint(0) : (ulint(1)<<width)-1;
+
+		words[word] = (words[word] & ~(mask<<offset)) | (x<<offset);
+
+		if(offset+width>64){
+
+			uint written = 64-offset;
+			words[word+1] = (words[word+1] & ~(mask>>written)) | (x>>written);
+
+		}
+
+	}
+
+	ulint subtree_size(uint32_t node, uint h){
+
+		if(h==0)
+			return leaves[node].size;
+
+		ulint s = 0;
+		for(auto x : inners[node].sizes)
+			s += x;
+
+		return s;
+
+	}
+
+	/*
+	 * insert w in position i of the subtree rooted in node (at height h; h=0: leaf).
+	 * Returns true if node has been split: the new right sibling is stored in new_node.
+	 */
+	bool insert(uint32_t node, uint h, ulint i, ulint w, uint32_t & new_node){
+
+		if(h==0)
+			return insert_in_leaf(node, i, w, new_node);
+
+		uint k = 0;
+
+		{
+			inner_t & in = inners[node];
+			while(k+1<in.child.size() and i > in.sizes[k]){
+				i -= in.sizes[k];
+				k++;
+			}
+		}
+
+		uint32_t child_node = inners[node].child[k];
+		uint32_t new_child;
+
+		bool split = insert(child_node, h-1, i, w, new_child);
+
+		//the recursive call may have reallocated the pools: take the reference again
+		inner_t & in = inners[node];
+
+		in.sizes[k]++;
+
+		if(not split)
+			return false;
+
+		in.child.insert(in.child.begin()+k+1, new_child);
+		in.sizes[k] = subtree_size(child_node, h-1);
+		in.sizes.insert(in.sizes.begin()+k+1, subtree_size(new_child, h-1));
+
+		if(in.child.size()<=fanout)
+			return false;
+
+		//split this node: move the right half of the children to a new node
+		uint32_t r = new_inner();
+
+		inner_t & left = inners[node];
+		inner_t & right = inners[r];
+		uint half = left.child.size()/2;
+
+		right.child = vector<uint32_t>(left.child.begin()+half, left.child.end());
+		right.sizes = vector<ulint>(left.sizes.begin()+half, left.sizes.end());
+
+		left.child.resize(half);
+		left.sizes.resize(half);
+
+		new_node = r;
+
+		return true;
+
+	}
+
+	bool insert_in_leaf(uint32_t node, ulint i, ulint w, uint32_t & new_node){
+
+		assert(i<=leaves[node].size);
+
+		if(leaves[node].size<leaf_capacity){
+
+			leaf_t & l = leaves[node];
+
+			for(ulint j=l.size;j>i;j--)
+				set_field(l.words, j, get_field(l.words, j-1));
+
+			set_field(l.words, i, w);
+			l.size++;
+
+			return false;
+
+		}
+
+		//leaf is full: split it in two halves, then insert
+		new_node = new_leaf();
+
+		leaf_t & l = leaves[node];
+		leaf_t & right = leaves[new_node];
+
+		uint half = l.size/2;
+
+		for(uint j=half;j<l.size;j++)
+			set_field(right.words, j-half, get_field(l.words, j));
+
+		right.size = l.size-half;
+		l.size = half;
+
+		uint32_t unused;
+
+		if(i<=half)
+			insert_in_leaf(node, i, w, unused);
+		else
+			insert_in_leaf(new_node, i-half, w, unused);
+
+		return true;
+
+	}
+
+	bool underfull(uint32_t node, uint h){
+
+		if(h==0)
+			return leaves[node].size < leaf_capacity/4;
+
+		return inners[node].child.size() < fanout/4;
+
+	}
+
+	/*
+	 * remove the integer in position i of the subtree rooted in node (at height h). Children of node that become
+	 * underfull are merged with a sibling or rebalanced.
+	 */
+	ulint remove(uint32_t node, uint h, ulint i){
+
+		if(h==0){
+
+			leaf_t & l = leaves[node];
+
+			ulint w = get_field(l.words, i);
+
+			for(ulint j=i;j+1<l.size;j++)
+				set_field(l.words, j, get_field(l.words, j+1));
+
+			l.size--;
+
+			return w;
+
+		}
+
+		uint k = 0;
+
+		{
+			inner_t & in = inners[node];
+			while(i >= in.sizes[k]){
+				i -= in.sizes[k];
+				k++;
+			}
+		}
+
+		ulint w = remove(inners[node].child[k], h-1, i);
+
+		inner_t & in = inners[node];
+
+		in.sizes[k]--;
+
+		if(in.child.size()>1 and underfull(in.child[k], h-1))
+			rebalance(node, h, k+1<in.child.size() ? k : k-1);
+
+		return w;
+
+	}
+
+	//merge or rebalance children k and k+1 of node (at height h)
+	void rebalance(uint32_t node, uint h, uint k){
+
+		uint32_t a = inners[node].child[k];
+		uint32_t b = inners[node].child[k+1];
+
+		if(h==1)
+			rebalance_leaves(a, b);
+		else
+			rebalance_inners(a, b);
+
+		inner_t & in = inners[node];
+
+		//b is empty if it has been merged into a
+		bool merged = h==1 ? leaves[b].size==0 : inners[b].child.size()==0;
+
+		if(merged){
+
+			if(h==1) free_leaf(b);
+			else free_inner(b);
+
+			in.child.erase(in.child.begin()+k+1);
+			in.sizes.erase(in.sizes.begin()+k+1);
+
+		}else{
+
+			in.sizes[k+1] = subtree_size(b, h-1);
+
+		}
+
+		in.sizes[k] = subtree_size(a, h-1);
+
+	}
+
+	//merge leaf b into leaf a if they fit in one leaf, otherwise split their integers evenly
+	void rebalance_leaves(uint32_t a, uint32_t b){
+
+		leaf_t & la = leaves[a];
+		leaf_t & lb = leaves[b];
+
+		ulint total = la.size + lb.size;
+		ulint half = total <= leaf_capacity ? total : total/2;
+
+		if(la.size < half){
+
+			//move the first half-la.size integers of b to the end of a
+			ulint d = half-la.size;
+
+			for(ulint j=0;j<d;j++)
+				set_field(la.words, la.size+j, get_field(lb.words, j));
+
+			for(ulint j=d;j<lb.size;j++)
+				set_field(lb.words, j-d, get_field(lb.words, j));
+
+			la.size += d;
+			lb.size -= d;
+
+		}else{
+
+			//move the last la.size-half integers of a to the beginning of b
+			ulint d = la.size-half;
+
+			for(ulint j=lb.size;j>0;j--)
+				set_field(lb.words, j-1+d, get_field(lb.words, j-1));
+
+			for(ulint j=0;j<d;j++)
+				set_field(lb.words, j, get_field(la.words, half+j));
+
+			la.size -= d;
+			lb.size += d;
+
+		}
+
+	}
+
+	//merge internal node b into a if they fit in one node, otherwise split their children evenly
+	void rebalance_inners(uint32_t a, uint32_t b){
+
+		inner_t & ia = inners[a];
+		inner_t & ib = inners[b];
+
+		ulint total = ia.child.size() + ib.child.size();
+		ulint half = total <= fanout ? total : total/2;
+
+		if(ia.child.size() < half){
+
+			ulint d = half-ia.child.size();
+
+			ia.child.insert(ia.child.end(), ib.child.begin(), ib.child.begin()+d);
+			ia.sizes.insert(ia.sizes.end(), ib.sizes.begin(), ib.sizes.begin()+d);
+
+			ib.child.erase(ib.child.begin(), ib.child.begin()+d);
+			ib.sizes.erase(ib.sizes.begin(), ib.sizes.begin()+d);
+
+		}else{
+
+			ib.child.insert(ib.child.begin(), ia.child.begin()+half, ia.child.end());
+			ib.sizes.insert(ib.sizes.begin(), ia.sizes.begin()+half, ia.sizes.end());
+
+			ia.child.resize(half);
+			ia.sizes.resize(half);
+
+		}
+
+	}
+
+	uint width=64;
+	ulint max_length=0;
+	ulint current_length=0;
+
+	uint leaf_capacity=0;//max integers per leaf
+
+	vector<leaf_t> leaves;
+	vector<inner_t> inners;
+
+	vector<uint32_t> free_leaves;//indexes of the freed nodes, reused by new_leaf/new_inner
+	vector<uint32_t> free_inners;
+
+	uint32_t root=0;
+	uint height=0;//0: the root is a leaf
+
+};
+
+}//namespace bwtil
+
+#endif /* PACKED_DYNAMIC_VECTOR_H_ */
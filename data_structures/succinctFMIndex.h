@@ -61,9 +61,48 @@ public:
 
 	}
 
-	vector<ulint> getOccurrencies(string P){
+	//batched_locate: locate with IndexedBWT::convertToTextCoordinatesBatch (opt-in: see tools/locate-bench)
+	vector<ulint> getOccurrencies(string P, bool batched_locate = false){
 
-		return idxBWT.convertToTextCoordinates( idxBWT.BS(P) );
+		return locate( idxBWT.BS(P), batched_locate );
+
+	}
+
+	//BWT interval of the suffixes prefixed by P (backward search). Empty if P does not occur
+	pair<ulint, ulint> BS(string P){
+
+		return idxBWT.BS(P);
+
+	}
+
+	//number of occurrences of P. Only backward search: no LF walks are performed
+	ulint numberOfOccurrences(string P){
+
+		return numberOfOccurrences( BS(P) );
+
+	}
+
+	//number of occurrences in the BWT interval returned by BS
+	ulint numberOfOccurrences(pair<ulint, ulint> interval){
+
+		return interval.second>interval.first ? interval.second-interval.first : 0;
+
+	}
+
+	//returns at most max_hits occurrences of P (all of them if max_hits=0). Only max_hits SA pointers are retrieved
+	vector<ulint> getOccurrencesUpTo(string P, ulint max_hits, bool batched_locate = false){
+
+		return getOccurrencesUpTo( BS(P), max_hits, batched_locate );
+
+	}
+
+	//as above, on the BWT interval returned by BS (e.g. to count and locate with a single backward search)
+	vector<ulint> getOccurrencesUpTo(pair<ulint, ulint> interval, ulint max_hits, bool batched_locate = false){
+
+		if(max_hits>0 and interval.second>interval.first and interval.second-interval.first>max_hits)//truncate interval
+			interval.second = interval.first+max_hits;
+
+		return locate( interval, batched_locate );
 
 	}
 
@@ -137,6 +176,16 @@ public:
 
 private:
 
+	//text positions of the BWT interval. The batched locate is opt-in: it is not faster in the measurements of locate-bench
+	vector<ulint> locate(pair<ulint, ulint> interval, bool batched_locate){
+
+		if(batched_locate)
+			return idxBWT.convertToTextCoordinatesBatch( interval );
+
+		return idxBWT.convertToTextCoordinates( interval );
+
+	}
+
 	void build(string text, bool verbose= false){
 
 		this->n=text.length();
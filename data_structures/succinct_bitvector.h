@@ -156,6 +156,15 @@ public:
 
 	}
 
+	//issue a prefetch of the memory words accessed by at(i) and rank1(i)
+	inline void prefetch(ulint i){
+
+		__builtin_prefetch( bitvector.data() + i/word_length );
+		__builtin_prefetch( rank_ptrs_2.data() + i/word_length );
+		__builtin_prefetch( rank_ptrs_1.data() + i/word_length_2 );
+
+	}
+
 	void saveToFile(FILE *fp){
 
 		ulint rank_ptrs_1_size = rank_ptrs_1.size();
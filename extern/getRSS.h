@@ -117,6 +117,37 @@ inline size_t getCurrentRSS( )
 #endif
 }
 
+/**
+ * Stores the current and the peak resident set size (bytes) read from
+ * the same source, so that they can be compared: VmRSS and VmHWM of
+ * /proc/self/status on Linux, getCurrentRSS( ) and getPeakRSS( ) on
+ * the other OSes. The values are zero if they cannot be determined.
+ */
+inline void getRSS( size_t &current, size_t &peak )
+{
+#if defined(__linux__) || defined(__linux) || defined(linux) || defined(__gnu_linux__)
+	/* Linux ---------------------------------------------------- */
+	current = peak = 0;
+	FILE* fp = NULL;
+	if ( (fp = fopen( "/proc/self/status", "r" )) == NULL )
+		return;		/* Can't open? */
+	char line[256];
+	unsigned long kb;
+	while ( fgets( line, sizeof(line), fp ) != NULL )
+	{
+		if ( sscanf( line, "VmRSS: %lu kB", &kb ) == 1 )
+			current = (size_t)kb * 1024;
+		else if ( sscanf( line, "VmHWM: %lu kB", &kb ) == 1 )
+			peak = (size_t)kb * 1024;
+	}
+	fclose( fp );
+
+#else
+	current = getCurrentRSS( );
+	peak = getPeakRSS( );
+#endif
+}
+
 inline void printRSSstat(){
 
 	size_t peakSize = getPeakRSS( );
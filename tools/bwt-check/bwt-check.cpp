@@ -25,25 +25,214 @@
 #include "../../data_structures/FileReader.h"
 #include "../../data_structures/BackwardFileIterator.h"
 
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace bwtil;
 
+/*
+ * Parallel check. The text is split in segments delimited by anchors: an anchor is a text position q whose row
+ * on the BWT is found by backward-searching the text from the (approximate) segment boundary leftwards until the
+ * BWT interval contains a single row (i.e. T[q..e) occurs only once). Each segment is then inverted independently
+ * starting from the row of its right anchor and compared against a mmap'd slice of the text. At the end of each
+ * segment, the LF walk must land exactly on the row of the left anchor: in this way the segments chain into the
+ * whole sequential inversion, and the check is exact.
+ *
+ * The reported mismatch is the same as in the sequential check (the first one met by the inversion, i.e. the one at
+ * the largest text position). This is the first mismatch of the rightmost failing segment: the smallest inversion
+ * offset at which a failing segment starts is shared by the workers, and only the segments starting after it are
+ * stopped. If the rightmost failing segment does not reach the row of its left anchor, its walk is the sequential one
+ * and it is continued leftwards until the mismatch is found.
+ */
+
+const ulint segments_per_thread = 8;//more segments than threads to balance the load
+const ulint max_anchor_length = 1<<16;//max number of backward search steps while looking for an anchor
+
+struct mismatch_t{
+
+	bool found=false;
+	bool chain=false;//the LF walk of a segment did not reach the row of the next anchor
+	ulint position=0;//text position of the mismatch
+	uchar x=0,y=0;//inverted bwt and text characters
+
+};
+
+//returns the mismatch found (if any)
+mismatch_t parallelCheck(IndexedBWT &idxBWT, const uchar * text, ulint n, uint nr_of_threads){
+
+	ulint nr_of_segments = nr_of_threads*segments_per_thread;
+	if(nr_of_segments>n) nr_of_segments = n;
+
+	std::atomic<ulint> next(0);
+
+	auto run = [&](std::function<void(ulint)> job, ulint nr_of_jobs){
+
+		next = 0;
+
+		vector<std::thread> workers;
+		for(uint t=0;t<nr_of_threads;t++)
+			workers.push_back( std::thread( [&](){
+
+				ulint j;
+				while((j=next++)<nr_of_jobs)
+					job(j);
+
+			} ) );
+
+		for(auto &t : workers)
+			t.join();
+
+	};
+
+	//1) find anchors. anchor[s] = <text position, BWT row>, or <n+1,*> if no unique substring ends in segment boundary s.
+
+	vector<pair<ulint, ulint> > anchor(nr_of_segments,pair<ulint, ulint>(n+1,0));
+
+	run( [&](ulint s){
+
+		if(s==0) return;//segment 0 starts at text position 0: no anchor needed
+
+		ulint e = (s*n)/nr_of_segments;//right end of the searched substring
+		ulint lower_limit = ((s-1)*n)/nr_of_segments;//anchors must be strictly increasing
+
+		pair<ulint, ulint> interval(0,idxBWT.length());
+
+		ulint q = e;
+		while(q>lower_limit+1 and interval.second-interval.first>1 and e-q<max_anchor_length){
+
+			q--;
+			interval = idxBWT.BS(interval,text[q]);
+
+		}
+
+		//if T[q..e) does not occur in the bwt, there is a mismatch in [q,e): no anchor, the segment inversion finds it
+		if(interval.second-interval.first==1)
+			anchor[s] = pair<ulint, ulint>(q,interval.first);
+
+	}, nr_of_segments);
+
+	//keep only valid anchors. Add first text position and terminator (the row of the empty suffix is 0)
+	vector<pair<ulint, ulint> > anchors;
+	anchors.push_back(pair<ulint, ulint>(0,0));
+
+	for(auto a : anchor)
+		if(a.first>0 and a.first<=n)
+			anchors.push_back(a);
+
+	anchors.push_back(pair<ulint, ulint>(n,0));
+
+	cout << " " << anchors.size()-1 << " segments, " << nr_of_threads << " threads." << endl;
+
+	//2) invert segments and compare them with the text. mismatch[s] is the first mismatch met by the walk of segment s
+
+	std::atomic<ulint> first_failure(n+1);//smallest inversion offset at which a failing segment starts (n+1: none)
+	vector<mismatch_t> mismatch(anchors.size()-1);
+
+	auto fail = [&](ulint s, ulint position, uchar x, uchar y, bool chain){
+
+		mismatch[s].found = true;
+		mismatch[s].chain = chain;
+		mismatch[s].position = position;
+		mismatch[s].x = x;
+		mismatch[s].y = y;
+
+		ulint offset = n-anchors[s+1].first;
+		ulint current = first_failure.load();
+		while(offset<current and not first_failure.compare_exchange_weak(current,offset));
+
+	};
+
+	//segment s starts after a failing segment in the inversion order: its result is not needed
+	auto stopped = [&](ulint s){ return n-anchors[s+1].first > first_failure.load(std::memory_order_relaxed); };
+
+	run( [&](ulint s){
+
+		ulint row = anchors[s+1].second;
+		ulint i = anchors[s+1].first;
+
+		for(;i>anchors[s].first and not stopped(s);i--){
+
+			uchar x = idxBWT.at(row);
+
+			if(x != text[i-1]){
+
+				fail(s,i-1,x,text[i-1],false);
+				return;
+
+			}
+
+			row = idxBWT.LF(row);
+
+		}
+
+		if(s==0 or stopped(s) or row == anchors[s].second)
+			return;
+
+		//the walk does not reach the row of the left anchor. If this is the rightmost failing segment, the walk is the
+		//sequential one: go on leftwards until the mismatch is met.
+		for(;i>0 and not stopped(s);i--){
+
+			uchar x = idxBWT.at(row);
+
+			if(x != text[i-1]){
+
+				fail(s,i-1,x,text[i-1],false);
+				return;
+
+			}
+
+			row = idxBWT.LF(row);
+
+		}
+
+		//the rest of the text matches: a segment on the right fails too, and its mismatch is the one reported
+		if(i==0)
+			fail(s,anchors[s].first,0,0,true);
+
+	}, anchors.size()-1);
+
+	for(ulint s=mismatch.size();s>0;s--)
+		if(mismatch[s-1].found)
+			return mismatch[s-1];
+
+	return mismatch_t();
+
+}
+
  int main(int argc,char** argv) {
 
 #ifdef DEBUG
 	 cout << "\n ****** DEBUG MODE ******\n\n";
 #endif
 
-	if(argc != 3){
+	if(argc != 3 and argc != 4){
 		cout << "*** BWT check ***\n";
 		cout << "Given a bwt file and a text file, checks if the former is the valid bwt of the latter\n";
-		cout << "Usage: bwt-check bwt_file text_file\n";
+		cout << "Usage: bwt-check bwt_file text_file [threads]\n";
 		cout << "where:\n";
 		cout <<	"- bwt_file is the bwt of text_file, with a 0x0 byte as terminator character (must appear only once in the bwt!).\n";
 		cout <<	"- text_file is the plain text file whose bwt is supposed to be stored in bwt_file.\n";
+		cout <<	"- threads (optional, default 1). If > 1, the BWT is inverted in independent segments which are checked in parallel.\n";
 		exit(0);
 	}
 
+	uint nr_of_threads = 1;
+
+	if(argc==4){
+
+		if(atoi(argv[3])<=0){
+			cout << "Error: number of threads must be > 0.\n";
+			exit(1);
+		}
+
+		nr_of_threads = atoi(argv[3]);
+
+	}
+
     using std::chrono::high_resolution_clock;
     using std::chrono::duration_cast;
     using std::chrono::duration;
@@ -70,53 +259,107 @@ using namespace bwtil;
     }
 
     string path = string(argv[2]);
-	auto bfr = BackwardFileIterator(path);
 
-	if(bfr.length() != n_inv_bwt){
+	if(nr_of_threads>1){
 
-		cout << "\nError: the bwt file and the text input file do not have same length (excluding bwt terminator)\n";
-		cout << "text length = " << bfr.length() << ", bwt length (without terminator) = " << n_inv_bwt << endl;
-		cout << argv[1] << " " << "is not a valid BWT of " << argv[2] << endl;
-		exit(0);
+		int fd = open(path.c_str(), O_RDONLY);
 
-	}
+		struct stat st;
+		if(fd<0 or fstat(fd,&st)<0 or st.st_size==0){
+			cout << "Error while opening file " << path <<endl;
+			exit(0);
+		}
 
-	cout << "\nDone. Inverting the BWT and checking correctness ... " << endl;
+		ulint n_text = st.st_size;
 
-	//invert the bwt
+		if(n_text != n_inv_bwt){
 
-	ulint i=0;//number of steps
-	ulint bwt_pos=0;//position in the L column of the BWT.
+			cout << "\nError: the bwt file and the text input file do not have same length (excluding bwt terminator)\n";
+			cout << "text length = " << n_text << ", bwt length (without terminator) = " << n_inv_bwt << endl;
+			cout << argv[1] << " " << "is not a valid BWT of " << argv[2] << endl;
+			exit(0);
 
-	int perc, last_perc=-1;
+		}
 
-	uchar x,y;
+		const uchar * text = (const uchar *)mmap(NULL, n_text, PROT_READ, MAP_PRIVATE, fd, 0);
 
-	while(i<n_inv_bwt){
+		if(text == MAP_FAILED){
+			cout << "Error while mapping file " << path << " in memory" <<endl;
+			exit(0);
+		}
+
+		cout << "\nDone. Inverting the BWT and checking correctness in parallel ... " << endl;
+
+		mismatch_t mm = parallelCheck(idxBWT, text, n_text, nr_of_threads);
+
+		munmap((void *)text, n_text);
+		close(fd);
 
-		if((x=idxBWT.at(bwt_pos)) != (y=bfr.read())){
+		if(mm.found){
+
+			if(mm.chain)
+				cout << "\nError: the inverted bwt does not reach the expected BWT row at text position " << mm.position << ".\n";
+			else{
+				cout << "\nError: text file and inverted bwt do not match at position " << mm.position << ".\n";
+				cout << mm.x << " " << mm.y << " " << (uint)mm.x << " " << (uint)mm.y <<endl;
+			}
 
-			cout << "\nError: text file and inverted bwt do not match at position " << n_inv_bwt-i-1 << ".\n";
-			cout << x << " " << y << " " << (uint)x << " " << (uint)y <<endl;
 			cout << argv[1] << " " << "is not a valid BWT of " << argv[2] << endl;
 			exit(0);
 
 		}
 
-		bwt_pos = idxBWT.LF(bwt_pos);
-		i++;
+	}else{
 
-		perc = (i*100)/(n_inv_bwt-1);
-		if(perc>last_perc and perc%10==0){
+		auto bfr = BackwardFileIterator(path);
 
-			cout << perc << "% done"<<endl;
-			last_perc=perc;
+		if(bfr.length() != n_inv_bwt){
+
+			cout << "\nError: the bwt file and the text input file do not have same length (excluding bwt terminator)\n";
+			cout << "text length = " << bfr.length() << ", bwt length (without terminator) = " << n_inv_bwt << endl;
+			cout << argv[1] << " " << "is not a valid BWT of " << argv[2] << endl;
+			exit(0);
 
 		}
 
-	}
+		cout << "\nDone. Inverting the BWT and checking correctness ... " << endl;
+
+		//invert the bwt
+
+		ulint i=0;//number of steps
+		ulint bwt_pos=0;//position in the L column of the BWT.
+
+		int perc, last_perc=-1;
 
-	bfr.close();
+		uchar x,y;
+
+		while(i<n_inv_bwt){
+
+			if((x=idxBWT.at(bwt_pos)) != (y=bfr.read())){
+
+				cout << "\nError: text file and inverted bwt do not match at position " << n_inv_bwt-i-1 << ".\n";
+				cout << x << " " << y << " " << (uint)x << " " << (uint)y <<endl;
+				cout << argv[1] << " " << "is not a valid BWT of " << argv[2] << endl;
+				exit(0);
+
+			}
+
+			bwt_pos = idxBWT.LF(bwt_pos);
+			i++;
+
+			perc = (i*100)/(n_inv_bwt-1);
+			if(perc>last_perc and perc%10==0){
+
+				cout << perc << "% done"<<endl;
+				last_perc=perc;
+
+			}
+
+		}
+
+		bfr.close();
+
+	}
 
 	cout << "\nSUCCESS!\n";
 	cout << argv[1] << " " << "is the BWT of " << argv[2] << endl;
@@ -23,6 +23,9 @@
 //============================================================================
 
 #include <iostream>
+#include <fstream>
+#include <thread>
+#include <atomic>
 
 #include "../../data_structures/succinct_bitvector.h"
 #include "../../data_structures/DBhash.h"
@@ -35,52 +38,412 @@ using namespace std;
 
 /*
  * input: path of a text file, pattern length m
- * returns: a dB-hash data structure built on the text. Hash function used is the default (base b=4). word size w used is the optimal w=log_b(m*n), where n=text length
+ * returns: a dB-hash data structure built on the text. Hash function used is the default (base b=4) unless another type is
+ * specified. word size w used is the optimal w=log_b(m*n), where n=text length
  */
-DBhash buildFromFile(string text_path, uint m){
+DBhash buildFromFile(	string text_path, uint m, uint nr_of_threads = 1, ulint overload_threshold = 0,
+						DBhash::text_format format = DBhash::plain_text, hash_type type = DEFAULT, uint quality_threshold = 15){
 
 	// 1) read text from file
 
 	FileReader fr = FileReader(text_path);
-	//ulint n = fr.size();
+	ulint n = fr.size();
 	string text = fr.toString();
 	fr.close();
 
 	// 2) create the hash function
 
-	//hash function for DNA search. Use only if the file is on the alphabet {A,C,G,T,N}
-	//n is the file length
+	HashFunction h;
 
-	//general purpose hash function: detect automatically alphabet size
-	HashFunction h = HashFunction(m,text_path,true);
+	if(type==DEFAULT){
 
-	//other hash functions (uncomment also n variable above)
+		//general purpose hash function: detect automatically alphabet size
+		h = HashFunction(m,text_path,true);
 
-	//bisulfite search (ACTGN alphabet, identifies C=T and G=A)
-	//HashFunction h = HashFunction(n,m,BS_SEARCH);
+	}else{
+
+		//DNA_SEARCH: DNA search (ACTGN alphabet). BS_SEARCH: bisulfite search (ACTGN alphabet, identifies C=T and G=A).
+		//QUALITY_DNA_SEARCH, QUALITY_BS_SEARCH: the text is a quality string (Phred+33). Use DNA and BS types only if the
+		//file is on the alphabet {A,C,G,T,N}. n is the file length
+		h = HashFunction(n,m,type,quality_threshold,true);
 
-	//DNA search (ACTGN alphabet)
-	//HashFunction h = HashFunction(n,m,DNA_SEARCH);
+	}
 
 	//build dBhash data structure
 
 	//offrate=16, verbose=true
-	DBhash dBhash = DBhash(text,h,16,true);
+	DBhash dBhash = DBhash(text,h,16,true,nr_of_threads,overload_threshold,format);
 
 	return dBhash;
 
+}
+
+/*
+ * reads a FASTA, FASTQ or plain (one read per line) file of reads, in batches
+ */
+class ReadsReader{
+
+public:
+
+	struct read{
+
+		string id;
+		string sequence;
+		string quality;//empty if not FASTQ
+
+	};
+
+	ReadsReader(string path){
+
+		in.open(path);
+
+		if(not in.good()){
+			cout << "Cannot open file " << path << endl;
+			exit(1);
+		}
+
+		int c = in.peek();
+
+		format = c=='>' ? fasta : (c=='@' ? fastq : plain);
+
+	}
+
+	//fill batch with at most batch_size reads. Returns false if no read is left
+	bool nextBatch(vector<read> &batch, ulint batch_size){
+
+		batch.clear();
+
+		string line;
+
+		while(batch.size()<batch_size and nextLine(line)){
+
+			if(line.length()==0)
+				continue;
+
+			read r;
+
+			if(format==plain){
+
+				r.id = std::to_string(nr_of_reads);
+				r.sequence = line;
+
+			}else if(format==fastq){
+
+				r.id = readId(line);
+				nextLine(r.sequence);
+				nextLine(line);//'+' line
+				nextLine(r.quality);
+
+			}else{//fasta: the sequence can span several lines
+
+				r.id = readId(line);
+
+				while(in.peek()!='>' and nextLine(line))
+					r.sequence.append(line);
+
+			}
+
+			nr_of_reads++;
+			batch.push_back(r);
+
+		}
+
+		return batch.size()>0;
+
+	}
+
+	bool hasQualities(){return format==fastq;}
+
+private:
+
+	bool nextLine(string &line){
+
+		if(not getline(in,line))
+			return false;
+
+		if(line.length()>0 and line[line.length()-1]=='\r')
+			line.erase(line.length()-1);
+
+		return true;
+
+	}
+
+	//id = header without the leading '>' or '@', up to the first whitespace
+	string readId(string &header){
+
+		ulint end = header.find_first_of(" \t");
+
+		return header.substr(1, end==string::npos ? string::npos : end-1);
+
+	}
+
+	enum {fasta,fastq,plain} format;
+
+	ifstream in;
+	ulint nr_of_reads=0;
+
+};
+
+struct map_options{
+
+	uint max_errors = 0;
+	ulint max_hits = 0;//0 = all hits
+	uint nr_of_threads = std::thread::hardware_concurrency()>0 ? std::thread::hardware_concurrency() : 1;
+	uint quality_threshold = 0;
+
+};
+
+/*
+ * map all the reads of reads_path on the dB-hash. Reads are processed in batches; the reads of a batch are distributed
+ * among opt.nr_of_threads threads, and then the hits of the batch are written (in input order) to out_path.
+ */
+void mapReads(DBhash &dBhash, string reads_path, string out_path, map_options opt){
+
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration_cast;
+    using std::chrono::duration;
+
+	ReadsReader reader(reads_path);
+
+	ofstream out(out_path);
+
+	if(not out.good()){
+		cout << "Cannot open file " << out_path << endl;
+		exit(1);
+	}
+
+	ulint m = dBhash.patternLength();
+
+	if(opt.max_errors>dBhash.hashFunction().maxErrors()){
+		cout << "Error: at most " << dBhash.hashFunction().maxErrors() << " errors are supported" << endl;
+		exit(1);
+	}
+
+	//quality hash function: low-quality bases become wildcards in the fingerprint
+	HashFunction qh;
+	bool use_qualities = opt.quality_threshold>0 and reader.hasQualities();
+
+	if(use_qualities and not dBhash.qualityHashFunction(opt.quality_threshold,qh)){
+		cout << "Warning: the hash function of the index is not compatible with quality hash functions. Qualities are ignored." << endl;
+		use_qualities = false;
+	}
+
+	cout << "\nMapping reads of " << reads_path << " with " << opt.nr_of_threads << " threads (max " << opt.max_errors << " errors"
+		 << (use_qualities ? ", low quality bases as wildcards" : "") << ")" << endl;
+
+	ulint batch_size = 16384;
+	vector<ReadsReader::read> batch;
+	vector<vector<pair<ulint, uint> > > hits;
+
+	ulint nr_of_reads=0, mapped_reads=0, nr_of_hits=0;
+	std::atomic<ulint> skipped_reads(0);
+
+	auto t1 = high_resolution_clock::now();
+
+	while(reader.nextBatch(batch,batch_size)){
+
+		hits = vector<vector<pair<ulint, uint> > >(batch.size());
+		std::atomic<ulint> next_read(0);
+
+		auto worker = [&](){
+
+			HashFunction h = dBhash.hashFunction();
+
+			ulint i;
+
+			while((i = next_read++) < batch.size()){
+
+				string &R = batch[i].sequence;
+				string &Q = batch[i].quality;
+
+				if(R.length()!=m){
+					skipped_reads++;
+					continue;
+				}
+
+				ulint wildcards = 0;
+				vector<bool> low_quality;//low-quality bases: never counted as mismatches
+
+				if(use_qualities and Q.length()==m){
+
+					wildcards = qh.hashValue(Q);
+
+					low_quality = vector<bool>(m);
+					for(ulint j=0;j<m;j++)
+						low_quality[j] = (uint)(uchar)Q[j] < 33+opt.quality_threshold;
+
+				}
+
+				auto candidates = dBhash.getCandidates(h.hashValue(R), opt.max_errors, wildcards);
+
+				hits[i] = dBhash.verifyOccurrences(R, candidates, opt.max_errors, low_quality);
+
+				if(opt.max_hits>0 and hits[i].size()>opt.max_hits)
+					hits[i].resize(opt.max_hits);
+
+			}
+
+		};
+
+		vector<std::thread> threads;
+
+		for(uint t=0;t<opt.nr_of_threads;t++)
+			threads.push_back(std::thread(worker));
+
+		for(auto &t : threads)
+			t.join();
+
+		for(ulint i=0;i<batch.size();i++){
+
+			for(auto hit : hits[i])
+				out << batch[i].id << "\t" << hit.first << "\t" << hit.second << "\n";
+
+			mapped_reads += hits[i].size()>0;
+			nr_of_hits += hits[i].size();
+
+		}
+
+		nr_of_reads += batch.size();
+
+	}
+
+	out.close();
+
+	auto t2 = high_resolution_clock::now();
+	double sec = duration_cast<duration<double, std::ratio<1>>>(t2 - t1).count();
+
+	cout << "Done." << endl << endl;
+	cout << " Reads : " << nr_of_reads << " (" << skipped_reads << " skipped: length different from " << m << ")" << endl;
+	cout << " Mapped reads : " << mapped_reads << endl;
+	cout << " Hits : " << nr_of_hits << " (written to " << out_path << ")" << endl;
+	cout << " Mapping time : " << sec << "s (" << (sec>0 ? nr_of_reads/sec : 0) << " reads/s)" << endl << endl;
+
+}
+
+struct policy_result{
+
+	vector<vector<ulint> > occ;//occurrences of each pattern found by the approximate search
+	ulint exact_fingerprint_hits = 0;//occurrences found searching only h(P) (no Z set probes)
+
+};
+
+/*
+ * build the dB-hash of text with the given hash policy and search the patterns with at most max_errors errors, printing the
+ * construction time, the hashing and search throughput, and the occurrences found searching only the fingerprint of the
+ * pattern (for spaced seeds, this finds also the occurrences with errors in the blocks that are not used).
+ */
+template<class hash_policy>
+policy_result policyBenchmark(string name, string &text, uint m, hash_policy policy, vector<string> &patterns, uint max_errors, uint nr_of_threads){
+
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration_cast;
+    using std::chrono::duration;
+
+	policy_result res;
+
+	auto t1 = high_resolution_clock::now();
+
+	HashFunction_t<hash_policy> h(text.length(),m,policy);
+	DBhash_t<hash_policy> dBhash(text,h,16,false,nr_of_threads);
+
+	auto t2 = high_resolution_clock::now();
+	double build_sec = duration_cast<duration<double, std::ratio<1>>>(t2 - t1).count();
+
+	h = dBhash.hashFunction();
+
+	ulint checksum = 0;//printed, so that hashing is not optimized away
+	ulint rounds = 100;
+
+	t1 = high_resolution_clock::now();
+
+	for(ulint r=0;r<rounds;r++)
+		for(auto &P : patterns)
+			checksum += h.hashValue(P);
+
+	t2 = high_resolution_clock::now();
+	double hash_sec = duration_cast<duration<double, std::ratio<1>>>(t2 - t1).count();
+
+	t1 = high_resolution_clock::now();
+
+	for(auto &P : patterns)
+		res.occ.push_back(dBhash.getApproximateOccurrencies(P,max_errors));
+
+	t2 = high_resolution_clock::now();
+	double search_sec = duration_cast<duration<double, std::ratio<1>>>(t2 - t1).count();
+
+	ulint nr_of_occ = 0;
+	for(auto &o : res.occ)
+		nr_of_occ += o.size();
+
+	for(auto &P : patterns)
+		res.exact_fingerprint_hits += dBhash.verifyOccurrences(P, dBhash.getCandidates(h.hashValue(P),0), max_errors).size();
+
+	cout << name << "	" << build_sec << "	" << (hash_sec>0 ? rounds*patterns.size()/hash_sec : 0) << "	" << (search_sec>0 ? patterns.size()/search_sec : 0) <<
+			"	" << nr_of_occ << "	" << res.exact_fingerprint_hits << "	(checksum " << checksum << ")" << endl;
+
+	return res;
+
+}
+
+//hash type from its name in the command line. Returns false if the name is not valid
+bool hashType(string name, hash_type &type){
+
+	if(name.compare("default")==0)
+		type = DEFAULT;
+	else if(name.compare("dna")==0)
+		type = DNA_SEARCH;
+	else if(name.compare("bs")==0)
+		type = BS_SEARCH;
+	else if(name.compare("quality-dna")==0)
+		type = QUALITY_DNA_SEARCH;
+	else if(name.compare("quality-bs")==0)
+		type = QUALITY_BS_SEARCH;
+	else
+		return false;
+
+	return true;
+
 }
 
  int main(int argc,char** argv) {
 
-	if(argc != 4){
+	if(argc < 4 and not (argc==3 and string(argv[1]).compare("load")==0)){
 		cout << "*** dB-hash data structure ***\n";
-		cout << "Usage: dB-hash option file [pattern] [pattern_length]\n";
+		cout << "Usage: dB-hash build file pattern_length [--threads t] [--overload t] [--text plain|packed] [--hash type] [--quality-threshold q]\n";
+		cout << "       dB-hash search file pattern [--count | --max-hits K] [--errors k]\n";
+		cout << "       dB-hash map file reads_file output_file [--errors k] [--max-hits K] [--threads t] [--quality-threshold q]\n";
+		cout << "       dB-hash load file [--overload t]\n";
+		cout << "       dB-hash policies file pattern_length [--errors k] [--threads t]\n";
 		cout << "where: \n";
-		cout <<	"- option = build|search.\n";
-		cout <<	"- file = path of the text file (if build mode) or dB-hash .dbh file (if search mode). \n";
+		cout <<	"- option = build|search|map|load|policies.\n";
+		cout <<	"- file = path of the text file (if build mode) or dB-hash .dbh file (if search/map/load mode). \n";
 		cout << "- pattern_length = In build mode, specify this parameter, which is the pattern length\n";
 		cout << "- pattern = must be specified in search mode. It is the pattern to be searched in the index.\n";
+		cout << "- --count = (optional, search mode) only count the text substrings with the same hash value as the pattern\n";
+		cout << "  (candidate occurrences, not verified against the text). No occurrence is located.\n";
+		cout << "- --max-hits K = (optional, search mode) locate and print at most K occurrences.\n";
+		cout << "- --errors k = (optional, search mode) approximate search: find all occurrences at Hamming distance at most k\n";
+		cout << "  from the pattern (k <= 2), and print the number of candidates and the search time for each number of errors.\n";
+		cout << "- reads_file = (map mode) FASTA, FASTQ or plain (one read per line) file of reads of length equal to the pattern length\n";
+		cout << "  of the dB-hash (other reads are skipped).\n";
+		cout << "- output_file = (map mode) the hits are written to this file, one per line, as: read_id <TAB> text position <TAB> mismatches.\n";
+		cout << "  In map mode, --errors k and --max-hits K apply to each read.\n";
+		cout << "- --threads t = (optional) number of threads. Default: 1 in build mode, number of hardware threads in map mode.\n";
+		cout << "- --quality-threshold q = (optional, map mode, FASTQ only) bases with Phred quality < q do not count as errors, and\n";
+		cout << "  the fingerprint digits they affect are treated as wildcards (quality hash functions). Default: q=0 (qualities ignored).\n";
+		cout << "- --overload t = (optional) build mode: store the text positions of the fingerprints with more than t occurrences\n";
+		cout << "  (overloaded fingerprints), so that queries hitting them do not locate each candidate. Default: t=0 (disabled).\n";
+		cout << "  load mode: print the fingerprints with more than t occurrences.\n";
+		cout << "- --text plain|packed = (optional, build mode) storage of the text used to verify the candidates: log(sigma) bits per\n";
+		cout << "  character (plain, default), or the most frequent characters in fewer bits and runs of the others as exceptions (packed).\n";
+		cout << "- --hash type = (optional, build mode) hash function: default (alphabet detected from the text), dna, bs (bisulfite),\n";
+		cout << "  quality-dna or quality-bs (the text is a quality string; characters with Phred quality < q, given with\n";
+		cout << "  --quality-threshold q, default 15, are marked in the fingerprints). Default: default.\n";
+		cout << "- policies mode builds the dB-hash of a DNA text (alphabet {A,C,G,T,N}) with the runtime DNA hash, the compile-time\n";
+		cout << "  DNA policy and a spaced-seed policy (even blocks), and compares construction and search on patterns drawn from\n";
+		cout << "  the text with k random mismatches (default k=1). Nothing is stored.\n";
+		cout << "- load mode prints the hash load (number of fingerprints for each number of occurrences in the text), the space of the\n";
+		cout << "  text and the verification throughput.\n";
 		exit(0);
 	}
 
@@ -88,7 +451,7 @@ DBhash buildFromFile(string text_path, uint m){
     using std::chrono::duration_cast;
     using std::chrono::duration;
 
-	int build=0,search=1;
+	int build=0,search=1,mapping=2,load=3,policies=4;
 
 	int mode;
 
@@ -96,6 +459,12 @@ DBhash buildFromFile(string text_path, uint m){
 		mode=build;
 	else if(string(argv[1]).compare("search")==0)
 		mode=search;
+	else if(string(argv[1]).compare("map")==0)
+		mode=mapping;
+	else if(string(argv[1]).compare("load")==0)
+		mode=load;
+	else if(string(argv[1]).compare("policies")==0)
+		mode=policies;
 	else{
 		cout << "Unrecognized option "<<argv[1]<<endl;
 		exit(0);
@@ -109,14 +478,274 @@ DBhash buildFromFile(string text_path, uint m){
 
 	string pattern;
 
+	bool count_only = false;
+	ulint max_hits = 0;//0 = locate all occurrences
+	uint max_errors = 0;
+
 	if(mode==search){
+
 		pattern = string(argv[3]);
 		m = pattern.length();
+
+		for(int i=4;i<argc;i++){
+
+			if(string(argv[i]).compare("--count")==0)
+				count_only = true;
+			else if(string(argv[i]).compare("--max-hits")==0 and i+1<argc and atoi(argv[i+1])>0)
+				max_hits = atoi(argv[++i]);
+			else if(string(argv[i]).compare("--errors")==0 and i+1<argc)
+				max_errors = atoi(argv[++i]);
+			else{
+				cout << "Unrecognized search options. Run without arguments to display usage." << endl;
+				exit(1);
+			}
+
+		}
+
+		if(count_only and (max_hits>0 or max_errors>0)){
+			cout << "Error: --count cannot be combined with other search options." << endl;
+			exit(1);
+		}
+
+	}
+
+	if(mode==mapping){
+
+		if(argc<5){
+			cout << "Error: missing output file. Run without arguments to display usage." << endl;
+			exit(1);
+		}
+
+		map_options opt;
+
+		for(int i=5;i<argc;i++){
+
+			if(string(argv[i]).compare("--errors")==0 and i+1<argc)
+				opt.max_errors = atoi(argv[++i]);
+			else if(string(argv[i]).compare("--max-hits")==0 and i+1<argc)
+				opt.max_hits = atoi(argv[++i]);
+			else if(string(argv[i]).compare("--threads")==0 and i+1<argc and atoi(argv[i+1])>0)
+				opt.nr_of_threads = atoi(argv[++i]);
+			else if(string(argv[i]).compare("--quality-threshold")==0 and i+1<argc)
+				opt.quality_threshold = atoi(argv[++i]);
+			else{
+				cout << "Unrecognized map options. Run without arguments to display usage." << endl;
+				exit(1);
+			}
+
+		}
+
+		cout << "Loading dB-hash from file "<< in <<endl;
+		DBhash dBhash = DBhash::loadFromFile(in);
+		cout << "Done." << endl;
+
+		mapReads(dBhash, string(argv[3]), string(argv[4]), opt);
+
+		printRSSstat();
+		exit(0);
+
+	}
+
+	if(mode==policies){
+
+		m = atoi(argv[3]);
+
+		uint nr_of_threads = 1;
+		max_errors = 1;
+
+		for(int i=4;i<argc;i++){
+
+			if(string(argv[i]).compare("--errors")==0 and i+1<argc)
+				max_errors = atoi(argv[++i]);
+			else if(string(argv[i]).compare("--threads")==0 and i+1<argc and atoi(argv[i+1])>0)
+				nr_of_threads = atoi(argv[++i]);
+			else{
+				cout << "Unrecognized policies options. Run without arguments to display usage." << endl;
+				exit(1);
+			}
+
+		}
+
+		if(max_errors>HashFunction().maxErrors()){
+			cout << "Error: at most " << HashFunction().maxErrors() << " errors are supported by the approximate search." << endl;
+			exit(1);
+		}
+
+		FileReader fr = FileReader(in);
+		string text = fr.toString();
+		fr.close();
+
+		if(m==0 or text.length()<m){
+			cout << "Error: the pattern length must be between 1 and the text length." << endl;
+			exit(1);
+		}
+
+		//patterns drawn from the text, with max_errors random mismatches
+		ulint nr_of_patterns = 2000;
+		vector<string> patterns;
+
+		srand(42);
+
+		for(ulint i=0;i<nr_of_patterns;i++){
+
+			string P = text.substr(rand()%(text.length()-m+1),m);
+
+			for(uint e=0;e<max_errors;e++){
+
+				ulint j = rand()%m;
+				P[j] = P[j]=='A' ? 'C' : 'A';
+
+			}
+
+			patterns.push_back(P);
+
+		}
+
+		cout << nr_of_patterns << " patterns of length " << m << " with " << max_errors << " mismatches" << endl << endl;
+		cout << "policy	build (s)	hash (patterns/s)	search (patterns/s)	occurrences	fingerprint-only occurrences" << endl;
+
+		auto runtime_res = policyBenchmark("runtime DNA_SEARCH", text, m, runtime_hash_policy(DNA_SEARCH), patterns, max_errors, nr_of_threads);
+		auto dna_res = policyBenchmark("dna_hash_policy", text, m, dna_hash_policy(), patterns, max_errors, nr_of_threads);
+		policyBenchmark("spaced_dna_hash_policy", text, m, spaced_dna_hash_policy<0x5555555555555555ULL>(), patterns, max_errors, nr_of_threads);
+
+		cout << endl << "dna_hash_policy and runtime DNA_SEARCH find " << (runtime_res.occ==dna_res.occ ? "the same" : "DIFFERENT") << " occurrences." << endl;
+
+		exit(0);
+
+	}
+
+	ulint overload_threshold = 0;
+
+	if(mode==load){
+
+		for(int i=3;i<argc;i++){
+
+			if(string(argv[i]).compare("--overload")==0 and i+1<argc and atoi(argv[i+1])>0)
+				overload_threshold = atoi(argv[++i]);
+			else{
+				cout << "Unrecognized load options. Run without arguments to display usage." << endl;
+				exit(1);
+			}
+
+		}
+
+		cout << "Loading dB-hash from file "<< in <<endl;
+		DBhash dBhash = DBhash::loadFromFile(in);
+		cout << "Done." << endl << endl;
+
+		auto t1 = high_resolution_clock::now();
+
+		dBhash.printHashLoad();
+
+		auto t2 = high_resolution_clock::now();
+
+		cout << "Hash load computed in " << duration_cast<duration<double, std::milli>>(t2 - t1).count() << " ms" << endl;
+
+		//verification throughput: candidates at random positions, patterns drawn from the text with 2 mismatches
+		{
+
+			ulint n = dBhash.textLength();
+			ulint m = dBhash.patternLength();
+			ulint nr_of_patterns = 1000;
+			ulint candidates_per_pattern = 100;
+
+			srand(42);
+
+			vector<string> patterns;
+
+			for(ulint i=0;i<nr_of_patterns;i++){
+
+				ulint pos = rand()%(n-m+1);
+				string P;
+
+				for(ulint j=0;j<m;j++)
+					P += dBhash.textAt(pos+j);
+
+				P[rand()%m] = 'x';
+				P[rand()%m] = 'y';
+
+				patterns.push_back(P);
+
+			}
+
+			ulint nr_of_good = 0;
+
+			auto t1 = high_resolution_clock::now();
+
+			for(auto P : patterns){
+
+				vector<ulint> occ;
+
+				for(ulint j=0;j<candidates_per_pattern;j++)
+					occ.push_back(rand()%(n-m+1));
+
+				nr_of_good += dBhash.filterOutBadOccurrences(P,occ,2).size();
+
+			}
+
+			auto t2 = high_resolution_clock::now();
+			double sec = duration_cast<duration<double, std::ratio<1>>>(t2 - t1).count();
+
+			cout << endl << "Text: " << (double)dBhash.textSize()/n << " bits per character (" << dBhash.numberOfExceptionRuns() << " exception runs)" << endl;
+			cout << "Verification: " << (sec>0 ? (nr_of_patterns*candidates_per_pattern)/sec : 0) << " candidates/s (" << nr_of_good << " at distance <= 2)" << endl << endl;
+
+		}
+
+		if(dBhash.numberOfOverloadedFingerprints()>0)
+			cout << "The index stores the positions of " << dBhash.numberOfOverloadedFingerprints() << " overloaded fingerprints (" <<
+					dBhash.overloadedPositions() << " positions)" << endl;
+
+		if(overload_threshold>0){
+
+			auto over = dBhash.overloadedFingerprints(overload_threshold);
+
+			cout << endl << over.size() << " fingerprints with more than " << overload_threshold << " occurrences:" << endl;
+			cout << "fingerprint\toccurrences" << endl;
+
+			for(auto f : over)
+				cout << dBhash.hashFunction().toString(f.first) << "\t" << f.second.second-f.second.first << endl;
+
+		}
+
+		printRSSstat();
+		exit(0);
+
 	}
 
-	if(mode==build)
+	uint nr_of_threads = 1;
+	DBhash::text_format format = DBhash::plain_text;
+	hash_type type = DEFAULT;
+	uint quality_threshold = 15;
+
+	if(mode==build){
+
 		m = atoi(argv[3]);
 
+		for(int i=4;i<argc;i++){
+
+			if(string(argv[i]).compare("--threads")==0 and i+1<argc and atoi(argv[i+1])>0)
+				nr_of_threads = atoi(argv[++i]);
+			else if(string(argv[i]).compare("--overload")==0 and i+1<argc and atoi(argv[i+1])>0)
+				overload_threshold = atoi(argv[++i]);
+			else if(string(argv[i]).compare("--text")==0 and i+1<argc and string(argv[i+1]).compare("plain")==0){
+				format = DBhash::plain_text;
+				i++;
+			}else if(string(argv[i]).compare("--text")==0 and i+1<argc and string(argv[i+1]).compare("packed")==0){
+				format = DBhash::packed_text;
+				i++;
+			}else if(string(argv[i]).compare("--hash")==0 and i+1<argc and hashType(argv[i+1],type))
+				i++;
+			else if(string(argv[i]).compare("--quality-threshold")==0 and i+1<argc)
+				quality_threshold = atoi(argv[++i]);
+			else{
+				cout << "Unrecognized build options. Run without arguments to display usage." << endl;
+				exit(1);
+			}
+
+		}
+
+	}
+
     auto t1 = high_resolution_clock::now();
 
 	DBhash dBhash;
@@ -125,7 +754,10 @@ DBhash buildFromFile(string text_path, uint m){
 
 
 		cout << "Building dB-hash of file "<< in << endl;
-		dBhash = buildFromFile(in,m);
+		dBhash = buildFromFile(in,m,nr_of_threads,overload_threshold,format,type,quality_threshold);
+
+		cout << "\nConstruction phases:" << endl;
+		dBhash.printBuildReport();
 
 		cout << "\nStoring dB-hash in "<< out<<endl;
 		dBhash.saveToFile(out);
@@ -147,12 +779,50 @@ DBhash buildFromFile(string text_path, uint m){
 
 		cout << "\nSearching pattern "<< pattern <<endl;
 
-		vector<ulint> occ = dBhash.getOccurrencies( pattern );
+		if(count_only){
 
-		cout << "The pattern occurs " << occ.size() << " times in the text at the following positions : \n";
+			cout << dBhash.numberOfOccurrencies( pattern ) << " text substrings have the same hash value as the pattern.\n";
 
-		for(uint i=0;i<occ.size();i++)
-			cout << occ.at(i) << " ";
+		}else if(max_errors>0){
+
+			DBhash::search_stats stats;
+
+			vector<ulint> occ = dBhash.getApproximateOccurrencies( pattern, max_errors, &stats );
+
+			cout << "errors\tfingerprints\tcandidates\tsearch+locate time (us)" << endl;
+
+			for(uint e=0;e<=max_errors;e++)
+				cout << e << "\t" << stats.probes[e] << "\t" << stats.candidates[e] << "\t" << stats.locate_ns[e]/1000 << endl;
+
+			cout << "verification time (us) : " << stats.verify_ns/1000 << endl << endl;
+
+			cout << "The pattern occurs " << occ.size() << " times in the text with at most " << max_errors << " errors";
+
+			if(max_hits>0 and occ.size()>max_hits){
+
+				occ.resize(max_hits);
+				cout << ". First " << max_hits << " positions";
+
+			}
+
+			cout << " : \n";
+
+			for(uint i=0;i<occ.size();i++)
+				cout << occ.at(i) << " ";
+
+		}else{
+
+			vector<ulint> occ = dBhash.getOccurrenciesUpTo( pattern, max_hits );
+
+			if(max_hits>0)
+				cout << "First " << occ.size() << " occurrences of the pattern in the text : \n";
+			else
+				cout << "The pattern occurs " << occ.size() << " times in the text at the following positions : \n";
+
+			for(uint i=0;i<occ.size();i++)
+				cout << occ.at(i) << " ";
+
+		}
 
 		cout << "\n\nDone.\n";
 
@@ -0,0 +1,501 @@
+/*
+ *  This file is part of BWTIL.
+ *  Copyright (c) by
+ *  Nicola Prezza <nicolapr@gmail.com>
+ *
+ *   BWTIL is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   BWTIL is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details (<http://www.gnu.org/licenses/>).
+ */
+
+//============================================================================
+// Name        : dbwt-bench.cpp
+// Author      : Nicola Prezza
+// Version     : 1.0
+// Copyright   : GNU General Public License (http://www.gnu.org/copyleft/gpl.html)
+// Description : benchmarks of the dynamic BWT (DynamicBWT)
+//============================================================================
+
+#include "../../data_structures/DynamicBWT.h"
+#include "../../data_structures/FileReader.h"
+#include "../../data_structures/lz77_parser.h"
+
+using namespace bwtil;
+
+using std::chrono::high_resolution_clock;
+using std::chrono::duration_cast;
+using std::chrono::duration;
+
+void help(){
+
+	cout << "*** dynamic BWT benchmark ***\n";
+	cout << "Usage: dbwt-bench mode text_file [options]\n";
+	cout << "Modes:\n";
+	cout << "extend : build the dynamic BWT of the text with one extend per character and with extend_batch (options: [batch_size], default 4096),\n";
+	cout << "         check that the two BWTs are equal and print the time per character.\n";
+	cout << "sigma  : build the dynamic BWT of uniform random texts on alphabets of size 4, 64 and 255, with length equal to the length\n";
+	cout << "         of text_file, and print the time per extend and the time of the F column updates alone (PartialSums vs. array of counters).\n";
+	cout << "vector : compare the dynamic vectors of the SA samples (dynamic_vector vs. packed_dynamic_vector): random inserts and accesses,\n";
+	cout << "         construction and locate of DynamicBWT, LZ77 parse with lz77_parser.\n";
+	cout << "locate : build the dynamic BWT of the text and print the time of LF (access + rank vs. access_rank) and of locate_right\n";
+	cout << "         on all BWT positions, one at a time and many at once (options: [sample_rate], default 8).\n";
+	cout << "window : sliding-window index (sliding_bwt_t): extend with all characters of the text, and remove_last the oldest\n";
+	cout << "         character when the window is full (options: [window_size], default 1/4 of the text length). Prints the time\n";
+	cout << "         per character of the steady state, of extend alone and of rebuilding the index of the window from scratch.\n";
+	exit(0);
+
+}
+
+/*
+ * the text remapped on the alphabet {0,...,sigma-1}, with the frequencies of the symbols
+ */
+struct remapped_text{
+
+	vector<symbol> S;
+	vector<ulint> freq;
+
+};
+
+remapped_text remap(string &text){
+
+	vector<ulint> code(256,0);
+	vector<bool> present(256,false);
+
+	for(auto c : text)
+		present[(uchar)c] = true;
+
+	ulint sigma=0;
+	for(uint c=0;c<256;c++)
+		if(present[c])
+			code[c] = sigma++;
+
+	remapped_text r;
+	r.freq = vector<ulint>(sigma,0);
+
+	for(auto c : text){
+
+		r.S.push_back(code[(uchar)c]);
+		r.freq[code[(uchar)c]]++;
+
+	}
+
+	return r;
+
+}
+
+double seconds(high_resolution_clock::time_point t1, high_resolution_clock::time_point t2){
+	return duration_cast<duration<double, std::ratio<1>>>(t2 - t1).count();
+}
+
+void extend_bench(string &text, ulint batch_size){
+
+	remapped_text r = remap(text);
+	ulint n = r.S.size();
+
+	cout << "text length: " << n << ", sigma = " << r.freq.size() << endl;
+
+	//best of 3 runs, alternating the two methods
+	double t_extend = 0, t_batch = 0;
+
+	for(uint run=0;run<3;run++){
+
+		auto t1 = high_resolution_clock::now();
+
+		dynamic_bwt_t bwt1(r.freq, 8);
+		for(ulint i=0;i<n;i++)
+			bwt1.extend(r.S[i]);
+
+		auto t2 = high_resolution_clock::now();
+
+		dynamic_bwt_t bwt2(r.freq, 8);
+		for(ulint i=0;i<n;i+=batch_size)
+			bwt2.extend_batch(r.S.data()+i, std::min(batch_size,n-i));
+
+		auto t3 = high_resolution_clock::now();
+
+		if(run==0 or seconds(t1,t2)<t_extend) t_extend = seconds(t1,t2);
+		if(run==0 or seconds(t2,t3)<t_batch) t_batch = seconds(t2,t3);
+
+		for(ulint i=0;i<bwt1.size();i++){
+
+			if(bwt1[i]!=bwt2[i] or (i>0 and bwt1.LF(i)!=bwt2.LF(i))){
+				cout << "Error: extend and extend_batch produced different BWTs (position " << i << ")" << endl;
+				exit(1);
+			}
+
+		}
+
+	}
+
+	cout << "extend       : " << (t_extend*1e9)/n << " ns/char" << endl;
+	cout << "extend_batch : " << (t_batch*1e9)/n << " ns/char (batches of " << batch_size << " characters)" << endl;
+
+}
+
+void sigma_bench(ulint n){
+
+	srand(1);
+
+	for(ulint sigma : {4,64,255}){
+
+		remapped_text r;
+		r.freq = vector<ulint>(sigma,0);
+
+		for(ulint i=0;i<n;i++){
+
+			r.S.push_back(rand()%sigma);
+			r.freq[r.S.back()]++;
+
+		}
+
+		auto t1 = high_resolution_clock::now();
+
+		dynamic_bwt_t bwt(r.freq, 8);
+		for(ulint i=0;i<n;i++)
+			bwt.extend(r.S[i]);
+
+		auto t2 = high_resolution_clock::now();
+
+		//F updates alone: one query and one update per character. At least 2^22 characters (the text is repeated)
+
+		ulint m = std::max(n,(ulint)1<<22);
+
+		PartialSums ps(sigma,m+1);
+		ps.setBaseCounter();
+		ulint check1=0;
+
+		for(ulint i=0;i<m;i++){
+
+			symbol s = r.S[i%n];
+			check1 += ps.getCount(s);
+			ps.increment(s);
+
+		}
+
+		auto t3 = high_resolution_clock::now();
+
+		vector<ulint> F(sigma,1);
+		ulint check2=0;
+
+		for(ulint i=0;i<m;i++){
+
+			symbol s = r.S[i%n];
+			check2 += F[s];
+			for(ulint j=s+1;j<sigma;j++)
+				F[j]++;
+
+		}
+
+		auto t4 = high_resolution_clock::now();
+
+		if(check1!=check2){
+			cout << "Error: PartialSums and array of counters differ" << endl;
+			exit(1);
+		}
+
+		cout << "sigma = " << sigma << " : extend " << (seconds(t1,t2)*1e9)/n << " ns/char. F updates: PartialSums " << (seconds(t2,t3)*1e9)/m;
+		cout << " ns/char, array " << (seconds(t3,t4)*1e9)/m << " ns/char" << endl;
+
+	}
+
+}
+
+template<class vector_type>
+void vector_ops_bench(string name, ulint n){
+
+	uint width = number_of_bits(n);
+
+	srand(1);
+
+	vector<ulint> pos;
+	for(ulint i=0;i<n;i++)
+		pos.push_back(rand()%(i+1));
+
+	auto t1 = high_resolution_clock::now();
+
+	vector_type v(n,width);
+	for(ulint i=0;i<n;i++)
+		v.insert(pos[i], i);
+
+	auto t2 = high_resolution_clock::now();
+
+	ulint sum = 0;
+	for(ulint i=0;i<n;i++)
+		sum += v[(i*7919)%n];
+
+	auto t3 = high_resolution_clock::now();
+
+	if(sum != (n*(n-1))/2){
+		cout << "Error: wrong content in " << name << endl;
+		exit(1);
+	}
+
+	cout << name << " : insert " << (seconds(t1,t2)*1e9)/n << " ns, access " << (seconds(t2,t3)*1e9)/n << " ns" << endl;
+
+}
+
+template<class vector_type>
+void vector_bwt_bench(string name, string &text, remapped_text &r){
+
+	ulint n = r.S.size();
+
+	auto t1 = high_resolution_clock::now();
+
+	DynamicBWT<bitv,vector_type> bwt(r.freq, 8);
+	for(ulint i=0;i<n;i++)
+		bwt.extend(r.S[i]);
+
+	auto t2 = high_resolution_clock::now();
+
+	ulint sum = 0;
+	for(ulint i=0;i<bwt.size();i++)
+		sum += bwt.locate_right(i);
+
+	auto t3 = high_resolution_clock::now();
+
+	if(sum != (n*(n+1))/2){
+		cout << "Error: wrong locate with " << name << endl;
+		exit(1);
+	}
+
+	set<pair<uchar,ulint> > aaf;
+
+	{
+		std::istringstream is(text);
+		aaf = lz77_parser<>::get_alphabet_and_frequencies(is);
+	}
+
+	auto t4 = high_resolution_clock::now();
+
+	std::istringstream is(text);
+	lz77_parser<bitv,vector_type> parser(is, aaf, 8);
+
+	ulint z = 0;
+	while(not parser.eof()){
+		parser.get_token_ref();
+		z++;
+	}
+
+	auto t5 = high_resolution_clock::now();
+
+	cout << name << " : extend " << (seconds(t1,t2)*1e9)/n << " ns/char, locate " << (seconds(t2,t3)*1e9)/bwt.size();
+	cout << " ns, lz77_parser " << (seconds(t4,t5)*1e9)/n << " ns/char (" << z << " phrases)" << endl;
+
+}
+
+void locate_bench(string &text, ulint sample_rate){
+
+	remapped_text r = remap(text);
+	ulint n = r.S.size();
+
+	dynamic_bwt_t bwt(r.freq, sample_rate);
+	for(ulint i=0;i<n;i+=4096)
+		bwt.extend_batch(r.S.data()+i, std::min((ulint)4096,n-i));
+
+	ulint m = bwt.size();
+
+	cout << "text length: " << n << ", sigma = " << r.freq.size() << ", sample rate = " << sample_rate << endl;
+
+	//LF on all positions but the terminator (F column position 0)
+	auto t1 = high_resolution_clock::now();
+
+	ulint check1 = 0;
+	for(ulint i=1;i<m;i++){
+
+		symbol s = bwt.access(i);
+		check1 += s==r.freq.size() ? 0 : bwt.F(s) + bwt.rank(s,i);
+
+	}
+
+	auto t2 = high_resolution_clock::now();
+
+	ulint check2 = 0;
+	for(ulint i=1;i<m;i++)
+		check2 += bwt.LF(i);
+
+	auto t3 = high_resolution_clock::now();
+
+	ulint sum1 = 0;
+	for(ulint i=0;i<m;i++)
+		sum1 += bwt.locate_right(i);
+
+	auto t4 = high_resolution_clock::now();
+
+	vector<ulint> positions(m);
+	for(ulint i=0;i<m;i++)
+		positions[i] = i;
+
+	ulint sum2 = 0;
+	for(auto x : bwt.locate_right(positions))
+		sum2 += x;
+
+	auto t5 = high_resolution_clock::now();
+
+	if(check1!=check2 or sum1!=(n*(n+1))/2 or sum2!=sum1){
+		cout << "Error: wrong LF or locate" << endl;
+		exit(1);
+	}
+
+	cout << "LF, access + rank       : " << (seconds(t1,t2)*1e9)/(m-1) << " ns" << endl;
+	cout << "LF, access_rank         : " << (seconds(t2,t3)*1e9)/(m-1) << " ns" << endl;
+	cout << "locate_right, single    : " << (seconds(t3,t4)*1e9)/m << " ns" << endl;
+	cout << "locate_right, many      : " << (seconds(t4,t5)*1e9)/m << " ns" << endl;
+
+}
+
+void window_bench(string &text, ulint w){
+
+	remapped_text r = remap(text);
+	ulint n = r.S.size();
+
+	w = std::min(w,n);
+
+	cout << "text length: " << n << ", sigma = " << r.freq.size() << ", window = " << w << endl;
+
+	//the frequencies in the whole text bound the frequencies in any window
+	sliding_bwt_t bwt(r.freq, 8);
+
+	for(ulint i=0;i<w;i++)
+		bwt.extend(r.S[i]);
+
+	auto t1 = high_resolution_clock::now();
+
+	for(ulint i=w;i<n;i++){
+
+		bwt.extend(r.S[i]);
+		bwt.remove_last();
+
+	}
+
+	auto t2 = high_resolution_clock::now();
+
+	//extend alone on a window of the same size
+	sliding_bwt_t bwt2(r.freq, 8);
+
+	for(ulint i=0;i<w;i++)
+		bwt2.extend(r.S[i]);
+
+	auto t3 = high_resolution_clock::now();
+
+	for(ulint i=w;i<n;i++)
+		bwt2.extend(r.S[i]);
+
+	auto t4 = high_resolution_clock::now();
+
+	//from scratch: the index of the last window
+	sliding_bwt_t bwt3(r.freq, 8);
+
+	for(ulint i=n-w;i<n;i++)
+		bwt3.extend(r.S[i]);
+
+	auto t5 = high_resolution_clock::now();
+
+	for(ulint i=0;i<bwt.size();i++){
+
+		if(bwt[i]!=bwt3[i] or bwt.locate_right(i)!=bwt3.locate_right(i)){
+			cout << "Error: the sliding-window index differs from the index of the last window (position " << i << ")" << endl;
+			exit(1);
+		}
+
+	}
+
+	ulint steps = n-w;
+
+	if(steps>0){
+
+		cout << "extend + remove_last : " << (seconds(t1,t2)*1e9)/steps << " ns/char" << endl;
+		cout << "extend alone         : " << (seconds(t3,t4)*1e9)/steps << " ns/char" << endl;
+
+	}
+
+	cout << "rebuild of the window: " << seconds(t4,t5)*1e3 << " ms (" << (seconds(t4,t5)*1e9)/w << " ns/char)" << endl;
+
+}
+
+void vector_bench(string &text){
+
+	ulint n = text.size();
+
+	cout << "Random inserts and accesses (" << n << " integers of " << number_of_bits(n) << " bits):" << endl;
+
+	vector_ops_bench<dynamic_vector_t>("dynamic_vector       ", n);
+	vector_ops_bench<packed_dynamic_vector>("packed_dynamic_vector", n);
+
+	cout << "SA samples of DynamicBWT (sample rate 8):" << endl;
+
+	remapped_text r = remap(text);
+
+	vector_bwt_bench<dynamic_vector_t>("dynamic_vector       ", text, r);
+	vector_bwt_bench<packed_dynamic_vector>("packed_dynamic_vector", text, r);
+
+}
+
+ int main(int argc,char** argv) {
+
+	if(argc < 3)
+		help();
+
+	string mode(argv[1]);
+
+	FileReader fr(argv[2]);
+	string text = fr.toString();
+	fr.close();
+
+	if(mode.compare("extend")==0){
+
+		ulint batch_size = 4096;
+
+		if(argc>3)
+			istringstream ( string(argv[3]) ) >> batch_size;
+
+		if(batch_size==0)
+			help();
+
+		extend_bench(text, batch_size);
+
+	}else if(mode.compare("vector")==0){
+
+		vector_bench(text);
+
+	}else if(mode.compare("locate")==0){
+
+		ulint sample_rate = 8;
+
+		if(argc>3)
+			istringstream ( string(argv[3]) ) >> sample_rate;
+
+		if(sample_rate==0)
+			help();
+
+		locate_bench(text, sample_rate);
+
+	}else if(mode.compare("window")==0){
+
+		ulint w = text.size()/4;
+
+		if(argc>3)
+			istringstream ( string(argv[3]) ) >> w;
+
+		if(w==0)
+			help();
+
+		window_bench(text, w);
+
+	}else if(mode.compare("sigma")==0){
+
+		sigma_bench(text.size());
+
+	}else{
+
+		cout << "Unrecognized mode " << mode << endl << endl;
+		help();
+
+	}
+
+ }
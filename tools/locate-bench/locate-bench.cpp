@@ -0,0 +1,192 @@
+/*
+ *  This file is part of BWTIL.
+ *  Copyright (c) by
+ *  Nicola Prezza <nicolapr@gmail.com>
+ *
+ *   BWTIL is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   BWTIL is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details (<http://www.gnu.org/licenses/>).
+ */
+
+//============================================================================
+// Name        : locate-bench.cpp
+// Author      : Nicola Prezza
+// Version     : 1.0
+// Copyright   : GNU General Public License (http://www.gnu.org/copyleft/gpl.html)
+// Description : traces the locate time vs. space curve of the SA sampling strategies of IndexedBWT
+//============================================================================
+
+#include "../../data_structures/IndexedBWT.h"
+#include "../../data_structures/FileReader.h"
+#include "../../algorithms/cw_bwt.h"
+
+using namespace bwtil;
+
+/*
+ * draw nr_of_queries patterns of length m from the text. A fraction hot_fraction of them starts inside a hot region
+ * of the text (1% of the text length), the others uniformly at random.
+ */
+vector<string> drawQueries(string &text, ulint m, ulint nr_of_queries, ulint hot_begin, ulint hot_length, double hot_fraction){
+
+	vector<string> queries;
+	ulint n = text.length();
+
+	for(ulint i=0;i<nr_of_queries;i++){
+
+		ulint pos;
+
+		if((double)(rand()%1000)/1000 < hot_fraction)
+			pos = hot_begin + rand()%hot_length;
+		else
+			pos = rand()%(n-m+1);
+
+		if(pos+m>n)
+			pos = n-m;
+
+		queries.push_back(text.substr(pos,m));
+
+	}
+
+	return queries;
+
+}
+
+ int main(int argc,char** argv) {
+
+	if(argc < 2 or argc > 4){
+		cout << "*** locate benchmark ***\n";
+		cout << "Builds the IndexedBWT of the text with each SA sampling strategy (text, bwt, run, adaptive) and different\n";
+		cout << "sample rates, and reports space of the SA samples vs. average locate time per occurrence (one occurrence at a time and batched).\n";
+		cout << "Usage: locate-bench text_file [pattern_length] [number_of_queries]\n";
+		cout << "where:\n";
+		cout <<	"- text_file is the input text file. It must not contain 0x0 bytes.\n";
+		cout <<	"- pattern_length (optional, default 12) is the length of the queries, which are drawn from the text (90% of them from a hot region).\n";
+		cout <<	"- number_of_queries (optional, default 10000).\n";
+		exit(0);
+	}
+
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration_cast;
+    using std::chrono::duration;
+
+	ulint m = 12;
+	ulint nr_of_queries = 10000;
+
+	if(argc>=3) m = atoi(argv[2]);
+	if(argc>=4) nr_of_queries = atoi(argv[3]);
+
+	FileReader fr(argv[1]);
+	string text = fr.toString();
+	fr.close();
+
+	ulint n = text.length();
+
+	if(m==0 or m>n){
+		cout << "Error: pattern length must be in [1,text length]" << endl;
+		exit(1);
+	}
+
+	cout << "Computing the BWT ... " << flush;
+	string bwt;
+	{
+		auto cwbwt = cw_bwt(text,cw_bwt::text);
+		bwt = cwbwt.toString();
+	}
+	cout << "done." << endl;
+
+	srand(42);
+
+	ulint hot_length = n/100+1;
+	ulint hot_begin = rand()%(n-hot_length+1);
+	double hot_fraction = 0.9;
+
+	//training queries: their occurrences form the query log of the adaptive sampler
+	vector<ulint> query_log;
+
+	{
+
+		auto training = drawQueries(text, m, nr_of_queries, hot_begin, hot_length, hot_fraction);
+		IndexedBWT idx(bwt,32);
+
+		for(auto P : training)
+			for(auto occ : idx.convertToTextCoordinates(idx.BS(P)))
+				query_log.push_back(occ);
+
+	}
+
+	auto queries = drawQueries(text, m, nr_of_queries, hot_begin, hot_length, hot_fraction);
+
+	//a block of the text is hot if it receives at least twice the average number of hits
+	ulint block_size = 1024;
+	ulint min_hits = (2*query_log.size())/(n/block_size+1) + 1;
+
+	vector<ulint> rates = {4,8,16,32,64,128};
+	vector<string> strategies = {"text","bwt","run","adaptive"};
+
+	cout << endl << "strategy\trate\tsamples\tSA bits/char\tns/occurrence\tns/occurrence (batched)" << endl;
+
+	for(auto strategy : strategies){
+
+		for(auto rate : rates){
+
+			SASampler * sampler;
+
+			if(strategy.compare("text")==0)
+				sampler = new TextSampler(rate);
+			else if(strategy.compare("bwt")==0)
+				sampler = new BWTSampler(rate);
+			else if(strategy.compare("run")==0)
+				sampler = new RunSampler(rate);
+			else
+				sampler = new AdaptiveSampler(rate, rate/8>0?rate/8:1, query_log, block_size, min_hits);
+
+			IndexedBWT idx(bwt,*sampler);
+			delete sampler;
+
+			//backward search is not timed: only locate
+			vector<pair<ulint, ulint> > intervals;
+			for(auto P : queries)
+				intervals.push_back(idx.BS(P));
+
+			ulint nr_of_occ=0;
+
+			auto t1 = high_resolution_clock::now();
+
+			for(auto I : intervals){
+
+				for(ulint i=I.first;i<I.second;i++)
+					idx.convertToTextCoordinate(i);
+
+				nr_of_occ += I.second-I.first;
+
+			}
+
+			auto t2 = high_resolution_clock::now();
+			double ns = duration_cast<duration<double, std::nano>>(t2 - t1).count();
+
+			//same queries, batched locate
+			t1 = high_resolution_clock::now();
+
+			for(auto I : intervals)
+				idx.convertToTextCoordinatesBatch(I);
+
+			t2 = high_resolution_clock::now();
+			double ns_batch = duration_cast<duration<double, std::nano>>(t2 - t1).count();
+
+			cout << 	strategy << "\t" << rate << "\t" << idx.numberOfSamples() << "\t" <<
+						(double)idx.sampledSASize()/n << "\t" << (nr_of_occ>0?ns/nr_of_occ:0) << "\t" <<
+						(nr_of_occ>0?ns_batch/nr_of_occ:0) << endl;
+
+		}
+
+	}
+
+	printRSSstat();
+
+ }
@@ -0,0 +1,75 @@
+/*
+ *  This file is part of BWTIL.
+ *  Copyright (c) by
+ *  Nicola Prezza <nicolapr@gmail.com>
+ *
+ *   BWTIL is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   BWTIL is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details (<http://www.gnu.org/licenses/>).
+ */
+
+#include "../../data_structures/lz77_format.h"
+
+using namespace bwtil;
+
+ int main(int argc,char** argv) {
+
+	if(argc != 3){
+		cout << "*** LZ77 decoder ***\n";
+		cout << "Reconstruct the text from its LZ77 parse in binary format (produced by lz77 --o).\n";
+		cout << "Usage: lz77-decode parse_file output_text_file\n";
+		exit(0);
+	}
+
+	using std::chrono::high_resolution_clock;
+	using std::chrono::duration_cast;
+	using std::chrono::duration;
+
+	FILE * fp;
+	if ((fp = fopen(argv[1], "rb")) == NULL) {
+		cout << "Cannot open file "  << argv[1] <<endl;
+		exit(1);
+	}
+
+	auto t1 = high_resolution_clock::now();
+
+	lz77_decoder decoder(fp);
+	fclose(fp);
+
+	auto t2 = high_resolution_clock::now();
+
+	string text(decoder.size(),0);
+	decoder.decode((uchar*)&text[0]);
+
+	auto t3 = high_resolution_clock::now();
+
+	if ((fp = fopen(argv[2], "wb")) == NULL) {
+		cout << "Cannot open file "  << argv[2] <<endl;
+		exit(1);
+	}
+
+	fwrite(text.data(), sizeof(uchar), text.size(), fp);
+	fclose(fp);
+
+	auto t4 = high_resolution_clock::now();
+
+	double load = duration_cast<duration<double, std::ratio<1>>>(t2 - t1).count();
+	double dec = duration_cast<duration<double, std::ratio<1>>>(t3 - t2).count();
+	double total = duration_cast<duration<double, std::ratio<1>>>(t4 - t1).count();
+
+	double MB = (double)text.size()/1000000;
+
+	cout << "number of phrases: " << decoder.numberOfTokens() << endl;
+	cout << "text size: " << text.size() << " bytes" << endl;
+	cout << "Load time: " << load << " s" << endl;
+	cout << "Decoding time: " << dec << " s (" << MB/dec << " MB/s)" << endl;
+	cout << "Total time (load + decode + write): " << total << " s (" << MB/total << " MB/s)" << endl;
+	cout << "Text saved to " << argv[2] << endl;
+
+ }
@@ -16,6 +16,8 @@
 
 #include "../../data_structures/LZ77.h"
 #include "../../data_structures/lz77_parser.h"
+#include "../../data_structures/lz77_format.h"
+#include "../../data_structures/lz77_parallel.h"
 #include <sstream>
 #include <iostream>
 #include <fstream>
@@ -24,6 +26,11 @@ using namespace bwtil;
 
 bool print_parse=false;
 bool save_parse=false;
+bool single_pass=false;
+ulint block_size=0;//block-parallel parse if >0
+ulint window=0;
+bool window_set=false;
+uint nr_of_threads=1;
 string out_filename;
 char sep_out;
 
@@ -36,6 +43,11 @@ void help(){
 	cout << "--v2 : LZ77 variant 2: when extending the current phrase W with a character c, if Wc does not occur previously, a new phrase W is inserted in the dictionary, and c is part of the next phrase. If W=empty, a new phrase 'c' is inserted in the dictionary, and the next phrase is initialized empty."<<endl;
 	cout << "--p arg : output the number of phrases every <arg> characters."<<endl;
 	cout << "--s arg : output the number of phrases each time a character equal to <arg> is encountered. Warning: <arg> characters are skipped and not taken into account in the LZ parse."<<endl;
+	cout << "--o arg : save the parse to file <arg> in binary format (decode it with lz77-decode). Phrases are the longest prefixes occurring before (possibly overlapping the phrase), or single characters at their first occurrence. Options --v1, --v2, --p and --s are ignored."<<endl;
+	cout << "--single-pass : with --o, read the input only once (the alphabet and the character frequencies are not computed in advance), so that text_file can be a pipe. Use text_file = - to read from standard input."<<endl;
+	cout << "--block arg : with --o, block-parallel parse: the file is split in blocks of <arg> characters that are parsed in parallel, and the phrases crossing the block boundaries are reconciled. The number of phrases is at most z_w + (number of blocks) - 1, where z_w is the number of phrases of the greedy parse with sources in a sliding window of size --window."<<endl;
+	cout << "--window arg : [default: block size] characters before each block that its phrases can copy from."<<endl;
+	cout << "--threads arg : [default:1] number of threads of the block-parallel parse."<<endl;
 	cout << "--verbose : [default:false] show percentage of work done."<<endl;
 	exit(0);
 }
@@ -72,6 +84,41 @@ lz77_t::options parse(lz77_t::options &opt, int &ptr, char** argv, int argc){
 
 		ptr++;
 
+	}else if(s.compare("--o")==0){
+
+		if(ptr>=argc){
+			cout<<"Missing output file in option --o" << endl;
+			help();
+		}
+
+		save_parse = true;
+		out_filename = string(argv[ptr]);
+		ptr++;
+
+	}else if(s.compare("--block")==0 or s.compare("--window")==0 or s.compare("--threads")==0){
+
+		if(ptr>=argc){
+			cout<<"Missing argument in option " << s << endl;
+			help();
+		}
+
+		long int value;
+		istringstream ( string(argv[ptr]) ) >> value;
+		ptr++;
+
+		if(value<=0){
+			cout << "error: argument of " << s << " must be > 0" << endl;
+			help();
+		}
+
+		if(s.compare("--block")==0) block_size = value;
+		if(s.compare("--window")==0){ window = value; window_set = true; }
+		if(s.compare("--threads")==0) nr_of_threads = value;
+
+	}else if(s.compare("--single-pass")==0){
+
+		single_pass = true;
+
 	}else if(s.compare("--verbose")==0){
 
 		opt.verbose = true;
@@ -102,6 +149,28 @@ lz77_t::options parse(lz77_t::options &opt, int &ptr, char** argv, int argc){
 	return opt;
 }
 
+/*
+ * write the whole parse. Phrases are not materialized: the sink keeps only the last character, which is the
+ * phrase itself for literals (first occurrences of a character)
+ */
+template<class parser_type>
+void write_parse(parser_type &parser, lz77_writer &writer){
+
+	uchar last=0;
+
+	while(not parser.eof()){
+
+		auto t = parser.get_token_ref([&last](char c){ last = c; });
+
+		if(t.source_is_defined)
+			writer.phrase(t.source, t.length);
+		else
+			writer.literal(last);
+
+	}
+
+}
+
  int main(int argc,char** argv) {
 
 /*	{
@@ -153,6 +222,135 @@ lz77_t::options parse(lz77_t::options &opt, int &ptr, char** argv, int argc){
 
 	}
 
+	if(save_parse){
+
+		using std::chrono::high_resolution_clock;
+		using std::chrono::duration_cast;
+		using std::chrono::duration;
+
+		auto t1 = high_resolution_clock::now();
+
+		FILE * fp;
+		if ((fp = fopen(out_filename.c_str(), "wb")) == NULL) {
+			cout << "Cannot open file "  << out_filename <<endl;
+			exit(1);
+		}
+
+		ulint n=0;
+		ulint number_of_phrases=0;
+		ulint bytes=0;
+		ulint rebuilds=0;
+		ulint capacity=0;
+
+		if(block_size>0){
+
+			lz77_parallel<> parser(argv[ptr], block_size, window_set ? window : block_size, nr_of_threads, 8, opt.verbose);
+
+			lz77_writer writer(fp, parser.size());
+
+			for(auto &p : parser.phrases()){
+
+				if(p.source_is_defined)
+					writer.phrase(p.source, p.length);
+				else
+					writer.literal(p.literal);
+
+			}
+
+			writer.close();
+
+			n = parser.size();
+			number_of_phrases = writer.numberOfTokens();
+			bytes = writer.bytes();
+
+			cout << "phrases before boundary reconciliation: " << parser.numberOfBlockPhrases() << endl;
+
+		}else if(single_pass){
+
+			//one pass on the input: the input may be a pipe (path "-" reads from standard input)
+			ifstream ifs;
+			istream * is = &cin;
+
+			if(string(argv[ptr]).compare("-")!=0){
+
+				ifs.open(argv[ptr]);
+
+				if(not ifs.is_open()){
+					cout << "Error: cannot open file " << argv[ptr] << endl;
+					exit(1);
+				}
+
+				is = &ifs;
+
+			}
+
+			lz77_parser<> parser(*is, 8, opt.verbose);
+			lz77_writer writer(fp);
+
+			write_parse(parser, writer);
+
+			writer.close();
+
+			n = parser.size();
+			number_of_phrases = writer.numberOfTokens();
+			bytes = writer.bytes();
+			rebuilds = parser.numberOfRebuilds();
+			capacity = parser.capacity();
+
+		}else{
+
+			set<pair<uchar,ulint> > aaf;
+
+			{
+				ifstream ifs(argv[ptr]);
+				if(not ifs.is_open()){
+					cout << "Error: cannot open file " << argv[ptr] << endl;
+					exit(1);
+				}
+				aaf = lz77_parser<>::get_alphabet_and_frequencies(ifs);
+			}
+
+			ifstream ifs(argv[ptr]);
+			lz77_parser<> parser(ifs, aaf, 8, opt.verbose);
+
+			lz77_writer writer(fp, parser.size());
+
+			write_parse(parser, writer);
+
+			writer.close();
+
+			n = parser.size();
+			number_of_phrases = writer.numberOfTokens();
+			bytes = writer.bytes();
+			capacity = parser.capacity();
+
+		}
+
+		fclose(fp);
+
+		auto t2 = high_resolution_clock::now();
+		double sec = duration_cast<duration<double, std::ratio<1>>>(t2 - t1).count();
+
+		cout << "number of phrases: " << number_of_phrases << endl;
+		cout << "text size: " << n << " bytes. Parse size: " << bytes << " bytes (" << (double)bytes*100/std::max(n,(ulint)1) << "%)" << endl;
+		if(block_size==0){
+			cout << "Dynamic BWT capacity: " << capacity << " characters";
+			if(single_pass)
+				cout << " (" << rebuilds << " re-encodings)";
+			cout << endl;
+		}
+		cout << "Compression time: " << sec << " s (" << ((double)n/1000000)/sec << " MB/s)" << endl;
+		cout << "Parse saved to " << out_filename << endl;
+
+		return 0;
+
+	}
+
+	if(single_pass or block_size>0){
+		cout << "Error: options --single-pass and --block require --o." << endl;
+		help();
+	}
+
 	opt.mode = file_path;//input string is a file path rather than a text to parse
 	opt.prepend_alphabet = false;//don't add the alphabet as prefix
 
@@ -32,13 +32,15 @@ using namespace std;
 
 int main(int argc,char** argv) {
 
-	if(argc != 4 and argc != 3){
+	if(argc < 3 or argc > 6){
 		cout << "*** succinct FM-index data structure : a wavelet-tree based uncompressed FM index ***\n";
-		cout << "Usage: sFM-index option file [pattern]\n";
+		cout << "Usage: sFM-index option file [pattern] [--count | --max-hits K]\n";
 		cout << "where:\n";
 		cout <<	"- option = build|search. \n";
 		cout << "- file = path of the text file (if build mode) or .sfm sFM-index file (if search mode). \n";
 		cout << "- pattern = must be specified in search mode. It is the pattern to be searched in the index.\n";
+		cout << "- --count = (optional, search mode) only count the occurrences. No occurrence is located.\n";
+		cout << "- --max-hits K = (optional, search mode) locate and print at most K occurrences.\n";
 		exit(0);
 	}
 
@@ -65,8 +67,27 @@ int main(int argc,char** argv) {
 
 	string pattern;
 
+	bool count_only = false;
+	ulint max_hits = 0;//0 = locate all occurrences
+
 	if(mode==search){
+
+		if(argc<4){
+			cout << "Error: missing pattern" << endl;
+			exit(1);
+		}
+
 		pattern = string(argv[3]);
+
+		if(argc==5 and string(argv[4]).compare("--count")==0)
+			count_only = true;
+		else if(argc==6 and string(argv[4]).compare("--max-hits")==0 and atoi(argv[5])>0)
+			max_hits = atoi(argv[5]);
+		else if(argc>4){
+			cout << "Unrecognized search options. Run without arguments to display usage." << endl;
+			exit(1);
+		}
+
 	}
 
     auto t1 = high_resolution_clock::now();
@@ -93,12 +114,30 @@ int main(int argc,char** argv) {
 
 		cout << "\nSearching pattern \""<< pattern << "\""<<endl;
 
-		vector<ulint> occ = SFMI.getOccurrencies( pattern );
+		if(count_only){
+
+			cout << "The pattern occurs " << SFMI.numberOfOccurrences( pattern ) << " times in the text.\n";
+
+		}else if(max_hits>0){
+
+			pair<ulint, ulint> interval = SFMI.BS( pattern );//a single backward search for count and locate
+			vector<ulint> occ = SFMI.getOccurrencesUpTo( interval, max_hits );
+
+			cout << "The pattern occurs " << SFMI.numberOfOccurrences( interval ) << " times in the text. First " << occ.size() << " located positions : \n";
+
+			for(uint i=0;i<occ.size();i++)
+				cout << occ.at(i) << " ";
+
+		}else{
+
+			vector<ulint> occ = SFMI.getOccurrencies( pattern );
+
+			cout << "The pattern occurs " << occ.size() << " times in the text at the following positions : \n";
 
-		cout << "The pattern occurs " << occ.size() << " times in the text at the following positions : \n";
+			for(uint i=0;i<occ.size();i++)
+				cout << occ.at(i) << " ";
 
-		for(uint i=0;i<occ.size();i++)
-			cout << occ.at(i) << " ";
+		}
 
 		cout << "\n\nDone.\n";
 
@@ -26,12 +26,15 @@
 #include "../../data_structures/sparse_bitvector.h"
 #include "../../data_structures/dynamic_vector.h"
 #include "../../data_structures/DynamicBWT.h"
+#include "../../data_structures/packed_dynamic_bitvector.h"
+#include "../../data_structures/packed_dynamic_vector.h"
 #include "../../data_structures/cgap_dictionary.h"
 #include "../../data_structures/bsd_cgap.h"
 #include "../../data_structures/fid_cgap.h"
 
 #include "bitview.h"
 #include <vector>
+#include <deque>
 
 
 using namespace bwtil;
@@ -201,6 +204,488 @@ void test_dynamic_vector(){
 	 cout << endl;
 }
 
+/*
+ * random insert/remove/set on a dynamic bitvector (of max size N) against a vector<char>: the bitvector is filled to N,
+ * drained to empty and filled again. Access and rank are checked at a random position after each operation, and on the
+ * whole bitvector every N/4 operations
+ */
+template<class bitvector_t>
+void test_dynamic_bitvector_updates(ulint N, string name){
+
+	bitvector_t B(N);
+	vector<char> V;
+
+	auto check_all = [&](){
+
+		ulint ones = 0;
+
+		for(ulint i=0;i<V.size();i++){
+
+			if(B.access(i)!=(bool)V[i] or B.rank(i,true)!=ones){
+				cout << "ERROR (" << name << "): wrong access/rank in position " << i << " of " << V.size() << endl;
+				exit(1);
+			}
+
+			ones += V[i];
+
+		}
+
+		if(B.size()!=V.size() or B.rank(V.size(),true)!=ones){
+			cout << "ERROR (" << name << "): wrong size or number of ones" << endl;
+			exit(1);
+		}
+
+	};
+
+	//phases: 0 = fill (mostly inserts), 1 = drain to empty (mostly removes), 2 = fill again
+	for(uint phase=0;phase<3;phase++){
+
+		ulint ops = 0;
+
+		while(phase==1 ? V.size()>0 : V.size()<N){
+
+			uint op = rand()%10;
+
+			if(V.size()==0) op = 0;
+			if(V.size()==N) op = 7;//remove
+
+			if(phase==1 ? op<3 : op<6){//insert
+
+				ulint i = rand()%(V.size()+1);
+				bool x = rand()%2;
+
+				B.insert(i,x);
+				V.insert(V.begin()+i,x);
+
+			}else if(op<8){//remove
+
+				ulint i = rand()%V.size();
+
+				if(B.remove(i)!=(bool)V[i]){
+					cout << "ERROR (" << name << "): remove returned the wrong bit" << endl;
+					exit(1);
+				}
+
+				V.erase(V.begin()+i);
+
+			}else{//set
+
+				ulint i = rand()%V.size();
+				bool x = rand()%2;
+
+				B.set(i,x);
+				V[i] = x;
+
+			}
+
+			if(V.size()>0){
+
+				ulint i = rand()%V.size();
+				ulint ones = 0;
+
+				for(ulint j=0;j<i;j++)
+					ones += V[j];
+
+				if(B.access(i)!=(bool)V[i] or B.rank(i,true)!=ones or B.rank(i,false)!=i-ones){
+					cout << "ERROR (" << name << "): wrong access/rank in position " << i << " of " << V.size() << endl;
+					exit(1);
+				}
+
+			}
+
+			if(++ops%(N/4)==0)
+				check_all();
+
+		}
+
+		check_all();
+
+	}
+
+	cout << name << " insert/remove/set: ok" << endl;
+
+}
+
+/*
+ * random insert/remove/set on a dynamic vector of max length N and width 'width' against a vector<ulint> (as
+ * test_dynamic_bitvector_updates)
+ */
+template<class vector_t>
+void test_dynamic_vector_updates(ulint N, uint width, string name){
+
+	vector_t D(N,width);
+	vector<ulint> V;
+
+	ulint max = width<64 ? ulint(1)<<width : 0;
+
+	auto random_value = [&](){ return max>0 ? ulint(rand())%max : ulint(rand()); };
+
+	auto check_all = [&](){
+
+		if(D.size()!=V.size()){
+			cout << "ERROR (" << name << "): wrong size" << endl;
+			exit(1);
+		}
+
+		for(ulint i=0;i<V.size();i++)
+			if(D[i]!=V[i]){
+				cout << "ERROR (" << name << "): wrong value in position " << i << " of " << V.size() << endl;
+				exit(1);
+			}
+
+	};
+
+	for(uint phase=0;phase<3;phase++){
+
+		ulint ops = 0;
+
+		while(phase==1 ? V.size()>0 : V.size()<N){
+
+			uint op = rand()%10;
+
+			if(V.size()==0) op = 0;
+			if(V.size()==N) op = 7;//remove
+
+			if(phase==1 ? op<3 : op<6){
+
+				ulint i = rand()%(V.size()+1);
+				ulint x = random_value();
+
+				D.insert(i,x);
+				V.insert(V.begin()+i,x);
+
+			}else if(op<8){
+
+				ulint i = rand()%V.size();
+
+				if(D.remove(i)!=V[i]){
+					cout << "ERROR (" << name << "): remove returned the wrong value" << endl;
+					exit(1);
+				}
+
+				V.erase(V.begin()+i);
+
+			}else{
+
+				ulint i = rand()%V.size();
+				ulint x = random_value();
+
+				D.set(i,x);
+				V[i] = x;
+
+			}
+
+			if(V.size()>0){
+
+				ulint i = rand()%V.size();
+
+				if(D[i]!=V[i]){
+					cout << "ERROR (" << name << "): wrong value in position " << i << " of " << V.size() << endl;
+					exit(1);
+				}
+
+			}
+
+			if(++ops%(N/4)==0)
+				check_all();
+
+		}
+
+		check_all();
+
+	}
+
+	cout << name << " insert/remove/set: ok" << endl;
+
+}
+
+/*
+ * random insert/remove/set on a dynamic string (frequencies freq, so at most the sum of freq characters) against a
+ * vector<symbol>: access and rank of all the symbols are checked
+ */
+void test_dynamic_string_updates(vector<ulint> freq){
+
+	ulint N = 0;
+	for(auto f : freq) N += f;
+
+	symbol sigma = freq.size();
+
+	DynamicString<packed_dynamic_bitvector> S(freq);
+	vector<symbol> V;
+	vector<ulint> count(sigma,0);
+
+	//random symbol that can still be inserted (at most freq[s] occurrences of s)
+	auto random_symbol = [&](){
+
+		symbol s;
+		do{ s = rand()%sigma; }while(count[s]==freq[s]);
+		return s;
+
+	};
+
+	auto check = [&](ulint i){
+
+		if(S.access(i)!=V[i]){
+			cout << "ERROR (DynamicString): wrong access in position " << i << " of " << V.size() << endl;
+			exit(1);
+		}
+
+		vector<ulint> r(sigma,0);
+		for(ulint j=0;j<i;j++) r[V[j]]++;
+
+		for(symbol s=0;s<sigma;s++)
+			if(S.rank(s,i)!=r[s]){
+				cout << "ERROR (DynamicString): wrong rank of " << s << " in position " << i << endl;
+				exit(1);
+			}
+
+	};
+
+	for(uint phase=0;phase<3;phase++){
+
+		while(phase==1 ? V.size()>0 : V.size()<N){
+
+			uint op = rand()%10;
+
+			if(V.size()==0) op = 0;
+			if(V.size()==N) op = 7;//remove
+
+			if(phase==1 ? op<3 : op<6){
+
+				ulint i = rand()%(V.size()+1);
+				symbol s = random_symbol();
+
+				S.insert(s,i);
+				V.insert(V.begin()+i,s);
+				count[s]++;
+
+			}else if(op<8){
+
+				ulint i = rand()%V.size();
+
+				if(S.remove(i)!=V[i]){
+					cout << "ERROR (DynamicString): remove returned the wrong symbol" << endl;
+					exit(1);
+				}
+
+				count[V[i]]--;
+				V.erase(V.begin()+i);
+
+			}else{
+
+				ulint i = rand()%V.size();
+
+				count[V[i]]--;
+				symbol s = random_symbol();
+				count[s]++;
+
+				if(S.set(i,s)!=V[i]){
+					cout << "ERROR (DynamicString): set returned the wrong symbol" << endl;
+					exit(1);
+				}
+
+				V[i] = s;
+
+			}
+
+			if(V.size()>0)
+				check(rand()%V.size());
+
+		}
+
+		for(ulint i=0;i<V.size();i++)
+			if(S.access(i)!=V[i]){
+				cout << "ERROR (DynamicString): wrong access in position " << i << " of " << V.size() << endl;
+				exit(1);
+			}
+
+	}
+
+	cout << "DynamicString (sigma = " << (uint)sigma << ") insert/remove/set: ok" << endl;
+
+}
+
+//random increment/decrement of PartialSums against an array of counters
+void test_partial_sums(uint sigma, ulint n){
+
+	PartialSums P(sigma,n);
+	vector<ulint> count(sigma,0);
+	ulint total = 0;
+
+	for(ulint k=0;k<20000;k++){
+
+		symbol s = rand()%sigma;
+		ulint x = 1 + rand()%4;
+
+		if(rand()%2 and total+x<=n){
+
+			P.increment(s,x);
+			count[s] += x;
+			total += x;
+
+		}else if(count[s]>=x){
+
+			P.decrement(s,x);
+			count[s] -= x;
+			total -= x;
+
+		}
+
+		//drain all the counters every 5000 operations
+		if(k%5000==4999)
+			for(symbol c=0;c<sigma;c++)
+				if(count[c]>0){
+
+					P.decrement(c,count[c]);
+					total -= count[c];
+					count[c] = 0;
+
+				}
+
+		ulint less = 0;
+
+		for(symbol c=0;c<sigma;c++){
+
+			if(P.getCount(c)!=less){
+				cout << "ERROR (PartialSums): wrong count of the symbols < " << c << endl;
+				exit(1);
+			}
+
+			less += count[c];
+
+		}
+
+	}
+
+	cout << "PartialSums (sigma = " << sigma << ") increment/decrement: ok" << endl;
+
+}
+
+/*
+ * compare a dynamic BWT of the text T with the BWT built from scratch on T (same frequencies and sample rate): characters,
+ * terminator position, F column and locate of every row
+ */
+template<class bwt_t>
+void check_against_rebuild(bwt_t & b, deque<symbol> & T, vector<ulint> freq, ulint sample_rate, string name){
+
+	bwt_t r(freq,sample_rate);
+
+	for(ulint i=T.size();i>0;i--)
+		r.extend(T[i-1]);
+
+	bool ok = b.size()==r.size() and b.terminator_position()==r.terminator_position();
+
+	for(ulint s=0;s<freq.size() and ok;s++)
+		ok = b.F(s)==r.F(s);
+
+	for(ulint i=0;i<r.size() and ok;i++)
+		ok = b[i]==r[i] and b.locate(i)==r.locate(i);
+
+	if(not ok){
+		cout << "ERROR (" << name << "): the BWT differs from the one rebuilt on the text (length " << T.size() << ")" << endl;
+		exit(1);
+	}
+
+}
+
+/*
+ * sliding window with frequencies summing to the window size (the only bound available on an unbounded stream): every
+ * extend of a full window inserts the first text position, which must not be sampled (sa_samples would overflow)
+ */
+void test_sliding_bwt_window_frequencies(){
+
+	ulint w = 1000;
+	ulint sample_rate = 32;
+	vector<ulint> freq = {w/2,w/2};
+
+	sliding_bwt_t b(freq,sample_rate);
+	deque<symbol> T;//T[0] is the last character inserted with extend
+
+	srand(42);
+
+	for(ulint k=0;k<20*w;k++){
+
+		if(T.size()==w){
+
+			b.remove_last();
+			T.pop_back();
+
+		}
+
+		symbol s = rand()%2;
+
+		b.extend(s);
+		T.push_front(s);
+
+		if(k%(3*w)==0)
+			check_against_rebuild(b,T,{w,w},sample_rate,"sliding window");
+
+	}
+
+	check_against_rebuild(b,T,{w,w},sample_rate,"sliding window");
+
+	cout << "sliding window with window frequencies: ok" << endl;
+
+}
+
+/*
+ * random extend/remove_last on a sliding_bwt_t against the BWT rebuilt on the text, at many points of the stream. The
+ * text is drawn from a small alphabet with repeats (so that remove_last reorders long runs of suffixes), the BWT is
+ * drained to the terminator and filled again
+ */
+void test_remove_last(uint sigma, ulint sample_rate){
+
+	ulint N = 600;
+	vector<ulint> freq(sigma,N);
+
+	sliding_bwt_t b(freq,sample_rate);
+	deque<symbol> T;
+
+	//next character of the stream: random, or a copy of a previous one (repeats)
+	auto next_symbol = [&](){
+
+		if(T.size()>8 and rand()%4)
+			return T[rand()%8];
+
+		return symbol(rand()%sigma);
+
+	};
+
+	ulint ops = 0;
+
+	for(uint phase=0;phase<3;phase++){
+
+		while(phase==1 ? T.size()>0 : T.size()<N){
+
+			bool remove = T.size()>0 and (phase==1 ? rand()%10<7 : rand()%10<3);
+
+			if(remove){
+
+				b.remove_last();
+				T.pop_back();
+
+			}else{
+
+				symbol s = next_symbol();
+
+				b.extend(s);
+				T.push_front(s);
+
+			}
+
+			if(++ops%23==0)
+				check_against_rebuild(b,T,freq,sample_rate,"remove_last");
+
+		}
+
+		check_against_rebuild(b,T,freq,sample_rate,"remove_last");
+
+	}
+
+	cout << "DynamicBWT::remove_last (sigma = " << sigma << ", sample rate " << sample_rate << "): ok" << endl;
+
+}
+
 char remap(symbol s){
 
 	switch(s){
@@ -217,6 +702,28 @@ char remap(symbol s){
 
  int main(int argc,char** argv) {
 
+	if(argc>1 and string(argv[1]).compare("dynamic")==0){
+
+		srand(42);
+
+		test_dynamic_bitvector_updates<packed_dynamic_bitvector>(70000,"packed_dynamic_bitvector");
+		test_dynamic_bitvector_updates<DummyDynamicBitvector>(3000,"DummyDynamicBitvector");
+		test_dynamic_vector_updates<packed_dynamic_vector>(30000,13,"packed_dynamic_vector");
+		test_dynamic_vector_updates<packed_dynamic_vector>(5000,64,"packed_dynamic_vector (width 64)");
+		test_dynamic_vector_updates<dynamic_vector_t>(5000,13,"dynamic_vector");
+		test_dynamic_string_updates({1500,700,300,50,10});
+		test_dynamic_string_updates({2000});
+		test_partial_sums(7,1000);
+		test_partial_sums(200,100000);
+		test_remove_last(2,1);
+		test_remove_last(4,4);
+		test_remove_last(4,32);
+		test_remove_last(20,8);
+		test_sliding_bwt_window_frequencies();
+		exit(0);
+
+	}
+
 	 {
 		vector<uchar> a(50000000);
 	 }